@@ -18,14 +18,125 @@ You should have received a copy of the GNU General Public License along with nem
 #include "alloc.h"
 
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "utils.h"
+
+// Header at the start of every mapped block, the rest of the block is handed out by alloc()
+struct arena_block {
+  arena_block_t *prev;
+  size_t size;  // including the header
+};
+
+private
+size_t round_to_pages(size_t size) {
+  size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+  return (size + page_size - 1) & ~(page_size - 1);
+}
+
+private
+void use_block(arena_t *a, arena_block_t *block) {
+  block->prev = a->blocks;
+  a->blocks = block;
+  a->beg = (char *)(block + 1);
+  a->end = (char *)block + block->size;
+}
+
+// Makes the arena able to hold `size` bytes aligned to `align`, the rest of the current block is
+// abandoned
+private
+bool grow(arena_t *a, ptrdiff_t size, ptrdiff_t align) {
+  size_t needed = sizeof(arena_block_t) + (size_t)size + (size_t)align;
+  if (needed < (size_t)size) {
+    return false;
+  }
+
+  for (arena_block_t **spare = &a->spare; *spare != nullptr; spare = &(*spare)->prev) {
+    if ((*spare)->size >= needed) {
+      arena_block_t *block = *spare;
+      *spare = block->prev;
+      use_block(a, block);
+      return true;
+    }
+  }
+
+  size_t block_size = round_to_pages(needed > a->block_size ? needed : a->block_size);
+  void *mem = mmap(nullptr, block_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mem == MAP_FAILED) {
+    return false;
+  }
+
+  arena_block_t *block = mem;
+  block->size = block_size;
+  use_block(a, block);
+  a->stats.reserved += block_size;
+  a->stats.block_count++;
+  return true;
+}
 
 void *alloc(arena_t *a, ptrdiff_t size, ptrdiff_t align, ptrdiff_t count, int8_t flags) {
   ptrdiff_t padding = -(uintptr_t)a->beg & (align - 1);
   ptrdiff_t available = a->end - a->beg - padding;
   if (available < 0 || count > available / size) {
-    return nullptr;
+    if (a->block_size == 0 || count > PTRDIFF_MAX / size || !grow(a, count * size, align)) {
+      a->stats.failures++;
+      return nullptr;
+    }
+    padding = -(uintptr_t)a->beg & (align - 1);
   }
+
   void *p = a->beg + padding;
   a->beg += padding + count * size;
+
+  a->stats.used += padding + count * size;
+  if (a->stats.used > a->stats.high_water) {
+    a->stats.high_water = a->stats.used;
+  }
   return flags & NOZERO ? p : memset(p, 0, count * size);
 }
+
+bool arena_new(arena_t *arena, size_t block_size) {
+  *arena = (arena_t){.block_size = block_size > 0 ? block_size : 1};
+  return_value_if(!grow(arena, 0, 1), false, "cannot map a %zu byte arena block", block_size);
+  return true;
+}
+
+private
+void unmap_blocks(arena_block_t *block) {
+  while (block != nullptr) {
+    arena_block_t *prev = block->prev;
+    munmap(block, block->size);
+    block = prev;
+  }
+}
+
+// Fixed arenas are left alone, their memory belongs to the caller
+void arena_free(arena_t *arena) {
+  if (arena->block_size == 0) {
+    return;
+  }
+
+  unmap_blocks(arena->blocks);
+  unmap_blocks(arena->spare);
+  *arena = (arena_t){};
+}
+
+arena_scope_t arena_scope_begin(arena_t *arena) {
+  return (arena_scope_t){arena, arena->beg, arena->end, arena->blocks, arena->stats.used};
+}
+
+// O(1) unless the arena grew inside the scope, the blocks it grew by are kept for reuse
+void arena_scope_end(arena_scope_t scope) {
+  arena_t *a = scope.arena;
+  while (a->blocks != scope.blocks) {
+    arena_block_t *block = a->blocks;
+    a->blocks = block->prev;
+    block->prev = a->spare;
+    a->spare = block;
+  }
+
+  a->beg = scope.beg;
+  a->end = scope.end;
+  a->stats.used = scope.used;
+}
@@ -29,9 +29,41 @@ You should have received a copy of the GNU General Public License along with nem
 
 #define NOZERO 1
 
+typedef struct arena_block arena_block_t;
+
+typedef struct {
+  size_t used;         // bytes handed out, including alignment padding
+  size_t high_water;   // the most `used` has ever been, size fixed arenas from this
+  size_t reserved;     // bytes mapped for blocks, including spare ones
+  size_t block_count;  // blocks mapped so far
+  size_t failures;     // allocations that returned nullptr
+} arena_stats_t;
+
+// An arena made of `(arena_t){.beg = mem, .end = mem + size}` is fixed, alloc() returns nullptr
+// once it is exhausted. One made by arena_new() maps another block whenever the current one runs
+// out.
 typedef struct {
   char *beg;
   char *end;
+  arena_block_t *blocks;  // newest first, nullptr for fixed arenas
+  arena_block_t *spare;   // blocks released by arena_scope_end(), reused before mapping new ones
+  size_t block_size;      // 0 for fixed arenas
+  arena_stats_t stats;
 } arena_t;
 
+// Allocations made between arena_scope_begin() and arena_scope_end() are released together, e.g.
+// everything a frame needs. Scopes nest but must end in the reverse order they began.
+typedef struct {
+  arena_t *arena;
+  char *beg;
+  char *end;
+  arena_block_t *blocks;
+  size_t used;
+} arena_scope_t;
+
 void *alloc(arena_t *a, ptrdiff_t size, ptrdiff_t align, ptrdiff_t count, int8_t flags);
+
+[[nodiscard]] bool arena_new(arena_t *arena, size_t block_size);
+void arena_free(arena_t *arena);
+arena_scope_t arena_scope_begin(arena_t *arena);
+void arena_scope_end(arena_scope_t scope);
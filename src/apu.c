@@ -0,0 +1,792 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#include "apu.h"
+
+#include "profile.h"
+#include "utils.h"
+
+// The APU is not clocked every CPU cycle. It is run up to the current cycle when one of its
+// registers is accessed or one of its events fires, and then only visits the cycles at which a
+// channel timer clocks. Every change of the mixer output is added to the current block as a
+// band-limited step, and apu_end_frame() integrates the block into 48kHz samples once per frame.
+
+static constexpr uint8_t KERNEL_PHASE_BITS = 6;
+static constexpr uint8_t KERNEL_PHASES = 1 << KERNEL_PHASE_BITS;
+
+// Blackman windowed sinc impulses with a cutoff at 0.45 of the sample rate, one per 1/64th of a
+// sample of delay. Every phase sums to exactly 1 << 15, so integrating them gives steps that
+// settle on the exact height of the delta.
+static constexpr int16_t step_kernel[KERNEL_PHASES][APU_KERNEL_TAPS] = {
+    {18, -110, 359, -843, 1561, -2371, 3025, 29490, 3025, -2371, 1561, -843, 359, -110, 18, 0},
+    {18, -109, 353, -820, 1492, -2199, 2566, 29481, 3495, -2543, 1628, -866, 364, -110, 18, 0},
+    {17, -108, 347, -795, 1421, -2025, 2117, 29452, 3974, -2714, 1693, -887, 369, -111, 18, 0},
+    {17, -107, 340, -769, 1349, -1852, 1679, 29400, 4463, -2883, 1757, -906, 373, -111, 18, 0},
+    {17, -105, 332, -742, 1276, -1679, 1252, 29332, 4960, -3051, 1818, -925, 376, -110, 17, 0},
+    {17, -104, 324, -715, 1202, -1507, 837, 29242, 5467, -3215, 1876, -941, 378, -110, 17, 0},
+    {16, -102, 315, -686, 1128, -1335, 434, 29131, 5981, -3378, 1932, -956, 380, -109, 17, 0},
+    {16, -100, 306, -657, 1052, -1165, 43, 29003, 6502, -3537, 1986, -970, 381, -108, 16, 0},
+    {16, -98, 297, -627, 977, -997, -336, 28853, 7031, -3693, 2036, -982, 381, -106, 16, 0},
+    {15, -95, 287, -597, 900, -830, -702, 28688, 7565, -3845, 2083, -991, 380, -105, 15, 0},
+    {15, -93, 277, -566, 824, -665, -1055, 28499, 8106, -3992, 2127, -999, 378, -103, 15, 0},
+    {14, -90, 267, -535, 748, -503, -1395, 28293, 8652, -4135, 2167, -1005, 376, -100, 14, 0},
+    {14, -87, 256, -503, 672, -343, -1721, 28067, 9203, -4273, 2204, -1009, 372, -97, 13, 0},
+    {13, -85, 245, -471, 597, -187, -2034, 27825, 9759, -4405, 2237, -1011, 367, -94, 12, 0},
+    {13, -82, 234, -439, 522, -34, -2334, 27565, 10317, -4531, 2266, -1011, 362, -91, 11, 0},
+    {12, -79, 223, -407, 447, 116, -2619, 27287, 10879, -4652, 2291, -1008, 355, -87, 10, 0},
+    {12, -76, 211, -375, 374, 262, -2891, 26992, 11444, -4765, 2311, -1004, 348, -83, 8, 0},
+    {11, -73, 200, -343, 301, 405, -3149, 26678, 12010, -4871, 2328, -997, 339, -78, 7, 0},
+    {10, -69, 188, -311, 229, 543, -3394, 26350, 12577, -4970, 2339, -987, 330, -73, 6, 0},
+    {10, -66, 177, -279, 159, 677, -3624, 26005, 13145, -5061, 2346, -976, 319, -68, 4, 0},
+    {9, -63, 165, -248, 90, 807, -3840, 25646, 13712, -5144, 2348, -962, 308, -62, 2, 0},
+    {9, -60, 153, -217, 22, 932, -4042, 25268, 14279, -5218, 2346, -945, 295, -56, 1, 1},
+    {8, -56, 142, -186, -44, 1052, -4231, 24877, 14845, -5283, 2338, -926, 282, -50, -1, 1},
+    {8, -53, 130, -156, -108, 1167, -4405, 24473, 15409, -5339, 2325, -905, 267, -43, -3, 1},
+    {7, -50, 119, -126, -171, 1277, -4566, 24057, 15970, -5386, 2307, -881, 251, -36, -5, 1},
+    {7, -47, 107, -96, -232, 1382, -4713, 23625, 16527, -5422, 2284, -854, 235, -28, -8, 1},
+    {6, -44, 96, -68, -291, 1482, -4846, 23182, 17081, -5448, 2255, -825, 217, -21, -10, 2},
+    {6, -40, 85, -39, -348, 1577, -4966, 22723, 17630, -5463, 2221, -794, 198, -12, -12, 2},
+    {5, -37, 74, -12, -403, 1666, -5072, 22257, 18174, -5467, 2182, -760, 178, -4, -15, 2},
+    {5, -34, 64, 15, -456, 1750, -5165, 21777, 18711, -5460, 2137, -724, 158, 5, -17, 2},
+    {4, -31, 53, 41, -506, 1828, -5246, 21289, 19243, -5441, 2086, -685, 136, 14, -20, 3},
+    {4, -28, 43, 66, -554, 1901, -5313, 20790, 19767, -5411, 2030, -644, 114, 23, -23, 3},
+    {3, -25, 33, 90, -600, 1968, -5368, 20283, 20283, -5368, 1968, -600, 90, 33, -25, 3},
+    {3, -23, 23, 114, -644, 2030, -5411, 19767, 20790, -5313, 1901, -554, 66, 43, -28, 4},
+    {3, -20, 14, 136, -685, 2086, -5441, 19243, 21289, -5246, 1828, -506, 41, 53, -31, 4},
+    {2, -17, 5, 158, -724, 2137, -5460, 18711, 21777, -5165, 1750, -456, 15, 64, -34, 5},
+    {2, -15, -4, 178, -760, 2182, -5467, 18174, 22257, -5072, 1666, -403, -12, 74, -37, 5},
+    {2, -12, -12, 198, -794, 2221, -5463, 17630, 22723, -4966, 1577, -348, -39, 85, -40, 6},
+    {2, -10, -21, 217, -825, 2255, -5448, 17081, 23182, -4846, 1482, -291, -68, 96, -44, 6},
+    {1, -8, -28, 235, -854, 2284, -5422, 16527, 23625, -4713, 1382, -232, -96, 107, -47, 7},
+    {1, -5, -36, 251, -881, 2307, -5386, 15970, 24057, -4566, 1277, -171, -126, 119, -50, 7},
+    {1, -3, -43, 267, -905, 2325, -5339, 15409, 24473, -4405, 1167, -108, -156, 130, -53, 8},
+    {1, -1, -50, 282, -926, 2338, -5283, 14845, 24877, -4231, 1052, -44, -186, 142, -56, 8},
+    {1, 1, -56, 295, -945, 2346, -5218, 14279, 25268, -4042, 932, 22, -217, 153, -60, 9},
+    {0, 2, -62, 308, -962, 2348, -5144, 13712, 25646, -3840, 807, 90, -248, 165, -63, 9},
+    {0, 4, -68, 319, -976, 2346, -5061, 13145, 26005, -3624, 677, 159, -279, 177, -66, 10},
+    {0, 6, -73, 330, -987, 2339, -4970, 12577, 26350, -3394, 543, 229, -311, 188, -69, 10},
+    {0, 7, -78, 339, -997, 2328, -4871, 12010, 26678, -3149, 405, 301, -343, 200, -73, 11},
+    {0, 8, -83, 348, -1004, 2311, -4765, 11444, 26992, -2891, 262, 374, -375, 211, -76, 12},
+    {0, 10, -87, 355, -1008, 2291, -4652, 10879, 27287, -2619, 116, 447, -407, 223, -79, 12},
+    {0, 11, -91, 362, -1011, 2266, -4531, 10317, 27565, -2334, -34, 522, -439, 234, -82, 13},
+    {0, 12, -94, 367, -1011, 2237, -4405, 9759, 27825, -2034, -187, 597, -471, 245, -85, 13},
+    {0, 13, -97, 372, -1009, 2204, -4273, 9203, 28067, -1721, -343, 672, -503, 256, -87, 14},
+    {0, 14, -100, 376, -1005, 2167, -4135, 8652, 28293, -1395, -503, 748, -535, 267, -90, 14},
+    {0, 15, -103, 378, -999, 2127, -3992, 8106, 28499, -1055, -665, 824, -566, 277, -93, 15},
+    {0, 15, -105, 380, -991, 2083, -3845, 7565, 28688, -702, -830, 900, -597, 287, -95, 15},
+    {0, 16, -106, 381, -982, 2036, -3693, 7031, 28853, -336, -997, 977, -627, 297, -98, 16},
+    {0, 16, -108, 381, -970, 1986, -3537, 6502, 29003, 43, -1165, 1052, -657, 306, -100, 16},
+    {0, 17, -109, 380, -956, 1932, -3378, 5981, 29131, 434, -1335, 1128, -686, 315, -102, 16},
+    {0, 17, -110, 378, -941, 1876, -3215, 5467, 29242, 837, -1507, 1202, -715, 324, -104, 17},
+    {0, 17, -110, 376, -925, 1818, -3051, 4960, 29332, 1252, -1679, 1276, -742, 332, -105, 17},
+    {0, 18, -111, 373, -906, 1757, -2883, 4463, 29400, 1679, -1852, 1349, -769, 340, -107, 17},
+    {0, 18, -111, 369, -887, 1693, -2714, 3974, 29452, 2117, -2025, 1421, -795, 347, -108, 17},
+    {0, 18, -110, 364, -866, 1628, -2543, 3495, 29481, 2566, -2199, 1492, -820, 353, -109, 18},
+};
+
+// the mixer output at full volume on every channel comes out at about this much
+static constexpr double MIX_SCALE = 24000.0;
+
+// y[n] = x[n] - x[n - 1] + R * y[n - 1] with R = exp(-2 * pi * 90 / 48000), the 90Hz high-pass of
+// the console's audio output, which also removes the DC offset of the mixer
+static constexpr int32_t HIGHPASS_R = 32384;
+
+static constexpr uint8_t DMC_STALL_CYCLES = 4;
+
+static constexpr uint8_t length_table[32] = {10, 254, 20,  2,  40, 4,  80, 6,  160, 8,  60,
+                                             10, 14,  12,  26, 14, 12, 16, 24, 18,  48, 20,
+                                             96, 22,  192, 24, 72, 26, 16, 28, 32,  30};
+
+static constexpr uint8_t duty_table[4][8] = {
+    {0, 1, 0, 0, 0, 0, 0, 0},
+    {0, 1, 1, 0, 0, 0, 0, 0},
+    {0, 1, 1, 1, 1, 0, 0, 0},
+    {1, 0, 0, 1, 1, 1, 1, 1},
+};
+
+static constexpr uint16_t noise_periods[2][16] = {
+    {4, 8, 16, 32, 64, 96, 128, 160, 202, 254, 380, 508, 762, 1016, 2034, 4068},
+    {4, 8, 14, 30, 60, 88, 118, 148, 188, 236, 354, 472, 708, 944, 1890, 3778},
+};
+
+static constexpr uint16_t dmc_rates[2][16] = {
+    {428, 380, 340, 320, 286, 254, 226, 214, 190, 160, 142, 128, 106, 84, 72, 54},
+    {398, 354, 316, 298, 276, 236, 210, 198, 176, 148, 132, 118, 98, 78, 66, 50},
+};
+
+// CPU cycles of the frame counter steps after the sequence starts, the last entry is the length
+// of the whole sequence
+static constexpr uint16_t frame_steps[2][2][6] = {
+    {{7457, 14913, 22371, 29829, 29830}, {7457, 14913, 22371, 29829, 37281, 37282}},
+    {{8313, 16627, 24939, 33253, 33254}, {8313, 16627, 24939, 33253, 41565, 41566}},
+};
+
+typedef enum { FRAME_QUARTER = 1, FRAME_HALF = 2, FRAME_IRQ = 4 } frame_action_t;
+
+static constexpr uint8_t frame_actions[2][5] = {
+    {FRAME_QUARTER, FRAME_QUARTER | FRAME_HALF, FRAME_QUARTER,
+     FRAME_QUARTER | FRAME_HALF | FRAME_IRQ},
+    {FRAME_QUARTER, FRAME_QUARTER | FRAME_HALF, FRAME_QUARTER, 0, FRAME_QUARTER | FRAME_HALF},
+};
+
+private
+uint8_t envelope_volume(const envelope_t *envelope) {
+  return envelope->constant_volume ? envelope->period : envelope->decay;
+}
+
+private
+void clock_envelope(envelope_t *envelope) {
+  if (envelope->start) {
+    envelope->start = false;
+    envelope->decay = 15;
+    envelope->divider = envelope->period;
+  } else if (envelope->divider == 0) {
+    envelope->divider = envelope->period;
+    if (envelope->decay > 0) {
+      envelope->decay--;
+    } else if (envelope->loop) {
+      envelope->decay = 15;
+    }
+  } else {
+    envelope->divider--;
+  }
+}
+
+// pulse 1 negates with ones' complement, pulse 2 with two's complement
+private
+bool sweep_muted(const pulse_t *pulse, uint16_t *target, bool first) {
+  uint16_t change = pulse->timer_period >> pulse->sweep_shift;
+
+  if (pulse->sweep_negate) {
+    *target = (uint16_t)(pulse->timer_period - change - first);
+  } else {
+    *target = pulse->timer_period + change;
+  }
+
+  return pulse->timer_period < 8 || (!pulse->sweep_negate && *target > 0x07FF);
+}
+
+private
+uint8_t pulse_output(const pulse_t *pulse) {
+  return duty_table[pulse->duty][pulse->sequence] ? pulse->volume : 0;
+}
+
+private
+uint8_t triangle_output(const triangle_t *triangle) {
+  return triangle->sequence < 16 ? 15 - triangle->sequence : triangle->sequence - 16;
+}
+
+private
+uint8_t noise_output(const noise_t *noise) {
+  return (noise->lfsr & 1) ? 0 : noise->volume;
+}
+
+private
+int32_t mix(const apu_t *apu) {
+  const apu_state_t *state = &apu->state;
+  uint8_t pulse = pulse_output(&state->pulse[0]) + pulse_output(&state->pulse[1]);
+  uint8_t tnd = (uint8_t)(3 * triangle_output(&state->triangle) +
+                          2 * noise_output(&state->noise) + state->dmc.output);
+
+  return apu->pulse_mix[pulse] + apu->tnd_mix[tnd];
+}
+
+private
+void add_delta(apu_t *apu, uint64_t cycle, int32_t delta) {
+  const apu_state_t *state = &apu->state;
+  uint64_t position = (cycle - state->block_start) * apu->samples_per_cycle + state->block_offset;
+  size_t index = position >> 32;
+
+  // the block was not read out in time, the step is lost
+  if (index >= APU_MAX_BLOCK_SAMPLES) {
+    return;
+  }
+
+  const int16_t *kernel = step_kernel[(position >> (32 - KERNEL_PHASE_BITS)) & (KERNEL_PHASES - 1)];
+  for (uint8_t i = 0; i < APU_KERNEL_TAPS; i++) {
+    apu->deltas[index + i] += delta * kernel[i];
+  }
+}
+
+private
+void update_output(apu_t *apu) {
+  apu_state_t *state = &apu->state;
+  if (apu->skip_audio) {
+    return;
+  }
+
+  int32_t output = mix(apu);
+
+  if (output != state->mix) {
+    add_delta(apu, state->cycle, output - state->mix);
+    state->mix = output;
+  }
+}
+
+// Works out the volume of every channel that is not muted, which only changes on register writes
+// and frame counter steps, so that a timer clock only has to look at the waveform. Timers of
+// channels that cannot change their output are stopped, so that they cost nothing while silent,
+// and restarted from the current cycle once they can. With skip_audio set the channels that only
+// make sound are stopped too, the DMC keeps running as it reads memory and raises IRQs.
+private
+void update_channels(apu_t *apu) {
+  apu_state_t *state = &apu->state;
+  triangle_t *triangle = &state->triangle;
+  noise_t *noise = &state->noise;
+
+  for (uint8_t i = 0; i < 2; i++) {
+    pulse_t *pulse = &state->pulse[i];
+    uint16_t target;
+    bool muted = pulse->length == 0 || sweep_muted(pulse, &target, i == 0);
+
+    pulse->volume = muted ? 0 : envelope_volume(&pulse->envelope);
+    if (apu->skip_audio || pulse->length == 0 || pulse->timer_period < 8) {
+      pulse->next_clock = UINT64_MAX;
+    } else if (pulse->next_clock == UINT64_MAX) {
+      pulse->next_clock = state->cycle + (uint64_t)(pulse->timer_period + 1) * 2;
+    }
+  }
+
+  // the triangle is not clocked at ultrasonic periods either, it would only add a DC offset
+  if (apu->skip_audio || triangle->length == 0 || triangle->linear_counter == 0 ||
+      triangle->timer_period < 2) {
+    triangle->next_clock = UINT64_MAX;
+  } else if (triangle->next_clock == UINT64_MAX) {
+    triangle->next_clock = state->cycle + triangle->timer_period + 1;
+  }
+
+  noise->volume = noise->length == 0 ? 0 : envelope_volume(&noise->envelope);
+  if (apu->skip_audio || noise->length == 0) {
+    noise->next_clock = UINT64_MAX;
+  } else if (noise->next_clock == UINT64_MAX) {
+    noise->next_clock = state->cycle + noise->timer_period;
+  }
+}
+
+private
+void update_irq(apu_t *apu) {
+  cpu_set_irq(apu->cpu, IRQ_SOURCE_APU_FRAME_COUNTER, apu->state.frame_irq);
+  cpu_set_irq(apu->cpu, IRQ_SOURCE_DMC, apu->state.dmc_irq);
+}
+
+private
+void restart_dmc(dmc_t *dmc) {
+  dmc->current_addr = dmc->sample_addr;
+  dmc->bytes_remaining = dmc->sample_length;
+}
+
+// The memory reader refills the sample buffer as soon as it is empty, taking the bus away from the
+// CPU for a few cycles
+private
+void fetch_dmc(apu_t *apu) {
+  apu_state_t *state = &apu->state;
+  dmc_t *dmc = &state->dmc;
+
+  if (dmc->buffer_full || dmc->bytes_remaining == 0) {
+    return;
+  }
+
+  dmc->buffer = bus_read(&apu->cpu->bus, dmc->current_addr);
+  dmc->buffer_full = true;
+  dmc->current_addr = dmc->current_addr == 0xFFFF ? 0x8000 : dmc->current_addr + 1;
+  apu->cpu->cycles += DMC_STALL_CYCLES;
+
+  if (--dmc->bytes_remaining == 0) {
+    if (dmc->loop) {
+      restart_dmc(dmc);
+    } else if (dmc->irq_enabled) {
+      state->dmc_irq = true;
+      update_irq(apu);
+    }
+  }
+}
+
+private
+void clock_dmc(apu_t *apu) {
+  dmc_t *dmc = &apu->state.dmc;
+
+  if (!dmc->silence) {
+    if (dmc->shift & 1) {
+      dmc->output = (uint8_t)(dmc->output + (dmc->output <= 125 ? 2 : 0));
+    } else {
+      dmc->output = (uint8_t)(dmc->output - (dmc->output >= 2 ? 2 : 0));
+    }
+    dmc->shift >>= 1;
+  }
+
+  if (--dmc->bits_remaining == 0) {
+    dmc->bits_remaining = 8;
+    dmc->silence = !dmc->buffer_full;
+    if (dmc->buffer_full) {
+      dmc->shift = dmc->buffer;
+      dmc->buffer_full = false;
+      fetch_dmc(apu);
+    }
+  }
+}
+
+// the next fetch happens when the output unit empties the buffer at the start of its next cycle,
+// if a register write moves it before the deadline the CPU is running to the CPU stops there
+private
+void schedule_dmc(apu_t *apu) {
+  const dmc_t *dmc = &apu->state.dmc;
+
+  if (dmc->bytes_remaining == 0) {
+    scheduler_cancel(apu->scheduler, EVENT_DMC_FETCH);
+    return;
+  }
+
+  uint64_t cycle = dmc->next_clock + (uint64_t)(dmc->bits_remaining - 1) * dmc->rate;
+  scheduler_schedule(apu->scheduler, EVENT_DMC_FETCH, cycle * apu->master_clocks_per_cpu_cycle);
+}
+
+// Runs every channel timer that clocks up to and including `cycle`
+private
+void run_until(apu_t *apu, uint64_t cycle) {
+  apu_state_t *state = &apu->state;
+  pulse_t *pulse = state->pulse;
+  triangle_t *triangle = &state->triangle;
+  noise_t *noise = &state->noise;
+  dmc_t *dmc = &state->dmc;
+  profile_component_t previous = profile_enter(PROFILE_APU);
+
+  for (;;) {
+    uint64_t next = dmc->next_clock;
+    next = pulse[0].next_clock < next ? pulse[0].next_clock : next;
+    next = pulse[1].next_clock < next ? pulse[1].next_clock : next;
+    next = triangle->next_clock < next ? triangle->next_clock : next;
+    next = noise->next_clock < next ? noise->next_clock : next;
+
+    if (next > cycle) {
+      break;
+    }
+    state->cycle = next;
+
+    for (uint8_t i = 0; i < 2; i++) {
+      if (pulse[i].next_clock == next) {
+        pulse[i].sequence = (pulse[i].sequence - 1) & 0x07;
+        pulse[i].next_clock += (uint64_t)(pulse[i].timer_period + 1) * 2;
+      }
+    }
+    if (triangle->next_clock == next) {
+      triangle->sequence = (triangle->sequence + 1) & 0x1F;
+      triangle->next_clock += triangle->timer_period + 1;
+    }
+    if (noise->next_clock == next) {
+      uint16_t feedback = (noise->lfsr ^ (noise->lfsr >> (noise->mode ? 6 : 1))) & 1;
+      noise->lfsr = (uint16_t)((noise->lfsr >> 1) | (feedback << 14));
+      noise->next_clock += noise->timer_period;
+    }
+    if (dmc->next_clock == next) {
+      clock_dmc(apu);
+      dmc->next_clock += dmc->rate;
+    }
+
+    update_output(apu);
+  }
+
+  state->cycle = cycle > state->cycle ? cycle : state->cycle;
+  profile_leave(previous);
+}
+
+private
+void sync(apu_t *apu) {
+  run_until(apu, apu->cpu->cycles);
+}
+
+private
+void clock_quarter_frame(apu_state_t *state) {
+  triangle_t *triangle = &state->triangle;
+
+  clock_envelope(&state->pulse[0].envelope);
+  clock_envelope(&state->pulse[1].envelope);
+  clock_envelope(&state->noise.envelope);
+
+  if (triangle->linear_reload) {
+    triangle->linear_counter = triangle->linear_period;
+  } else if (triangle->linear_counter > 0) {
+    triangle->linear_counter--;
+  }
+  if (!triangle->control) {
+    triangle->linear_reload = false;
+  }
+}
+
+private
+void clock_half_frame(apu_state_t *state) {
+  for (uint8_t i = 0; i < 2; i++) {
+    pulse_t *pulse = &state->pulse[i];
+    uint16_t target;
+
+    uint8_t step = (pulse->length > 0 && !pulse->envelope.loop) ? 1 : 0;
+    pulse->length = (uint8_t)(pulse->length - step);
+
+    if (pulse->sweep_divider == 0 && pulse->sweep_enabled && pulse->sweep_shift > 0 &&
+        !sweep_muted(pulse, &target, i == 0)) {
+      pulse->timer_period = target;
+    }
+    if (pulse->sweep_divider == 0 || pulse->sweep_reload) {
+      pulse->sweep_divider = pulse->sweep_period;
+      pulse->sweep_reload = false;
+    } else {
+      pulse->sweep_divider--;
+    }
+  }
+
+  uint8_t triangle_step = (state->triangle.length > 0 && !state->triangle.control) ? 1 : 0;
+  uint8_t noise_step = (state->noise.length > 0 && !state->noise.envelope.loop) ? 1 : 0;
+  state->triangle.length = (uint8_t)(state->triangle.length - triangle_step);
+  state->noise.length = (uint8_t)(state->noise.length - noise_step);
+}
+
+private
+void schedule_frame_counter(apu_t *apu) {
+  const apu_state_t *state = &apu->state;
+  uint64_t cycle = state->frame_start + frame_steps[apu->pal][state->five_step][state->frame_step];
+
+  scheduler_schedule(apu->scheduler, EVENT_APU_FRAME_COUNTER,
+                     cycle * apu->master_clocks_per_cpu_cycle);
+}
+
+private
+void on_frame_counter(void *ctx, uint64_t when) {
+  apu_t *apu = ctx;
+  apu_state_t *state = &apu->state;
+  uint8_t action = frame_actions[state->five_step][state->frame_step];
+
+  run_until(apu, when / apu->master_clocks_per_cpu_cycle);
+
+  if (action & FRAME_QUARTER) {
+    clock_quarter_frame(state);
+  }
+  if (action & FRAME_HALF) {
+    clock_half_frame(state);
+  }
+  if ((action & FRAME_IRQ) && !state->irq_inhibit) {
+    state->frame_irq = true;
+    update_irq(apu);
+  }
+
+  // the last step is followed by the end of the sequence
+  uint8_t steps = state->five_step ? 5 : 4;
+  if (++state->frame_step == steps) {
+    state->frame_step = 0;
+    state->frame_start += frame_steps[apu->pal][state->five_step][steps];
+  }
+
+  update_channels(apu);
+  update_output(apu);
+  schedule_frame_counter(apu);
+}
+
+private
+void on_dmc_fetch(void *ctx, uint64_t when) {
+  apu_t *apu = ctx;
+
+  run_until(apu, when / apu->master_clocks_per_cpu_cycle);
+  schedule_dmc(apu);
+}
+
+private
+void write_frame_counter(apu_t *apu, uint8_t val) {
+  apu_state_t *state = &apu->state;
+
+  state->five_step = get_7th_bit(val);
+  state->irq_inhibit = get_6th_bit(val);
+  if (state->irq_inhibit) {
+    state->frame_irq = false;
+    update_irq(apu);
+  }
+
+  // the sequence restarts a few cycles after the write, the five step mode clocks everything
+  // right away
+  state->frame_step = 0;
+  state->frame_start = state->cycle + 3;
+  if (state->five_step) {
+    clock_quarter_frame(state);
+    clock_half_frame(state);
+  }
+
+  schedule_frame_counter(apu);
+}
+
+private
+void write_status(apu_t *apu, uint8_t val) {
+  apu_state_t *state = &apu->state;
+  dmc_t *dmc = &state->dmc;
+
+  state->enabled = val & 0x1F;
+  state->pulse[0].length = (val & 0x01) ? state->pulse[0].length : 0;
+  state->pulse[1].length = (val & 0x02) ? state->pulse[1].length : 0;
+  state->triangle.length = (val & 0x04) ? state->triangle.length : 0;
+  state->noise.length = (val & 0x08) ? state->noise.length : 0;
+
+  if (!(val & 0x10)) {
+    dmc->bytes_remaining = 0;
+  } else if (dmc->bytes_remaining == 0) {
+    restart_dmc(dmc);
+    fetch_dmc(apu);
+  }
+
+  state->dmc_irq = false;
+  update_irq(apu);
+}
+
+private
+void write_pulse(apu_t *apu, pulse_t *pulse, uint8_t reg, uint8_t val) {
+  switch (reg) {
+    case 0:
+      pulse->duty = val >> 6;
+      pulse->envelope.loop = get_5th_bit(val);
+      pulse->envelope.constant_volume = val & 0x10;
+      pulse->envelope.period = get_lower_4_bits(val);
+      break;
+    case 1:
+      pulse->sweep_enabled = get_7th_bit(val);
+      pulse->sweep_period = (val >> 4) & 0x07;
+      pulse->sweep_negate = get_3rd_bit(val);
+      pulse->sweep_shift = val & 0x07;
+      pulse->sweep_reload = true;
+      break;
+    case 2:
+      pulse->timer_period = (pulse->timer_period & 0x0700) | val;
+      break;
+    default:
+      pulse->timer_period = (uint16_t)((pulse->timer_period & 0x00FF) | ((val & 0x07) << 8));
+      if (apu->state.enabled & (pulse == &apu->state.pulse[0] ? 0x01 : 0x02)) {
+        pulse->length = length_table[val >> 3];
+      }
+      pulse->sequence = 0;
+      pulse->envelope.start = true;
+  }
+}
+
+void apu_write_register(apu_t *apu, uint16_t addr, uint8_t val) {
+  apu_state_t *state = &apu->state;
+  triangle_t *triangle = &state->triangle;
+  noise_t *noise = &state->noise;
+  dmc_t *dmc = &state->dmc;
+
+  sync(apu);
+
+  switch (addr) {
+    case 0x4000:
+    case 0x4001:
+    case 0x4002:
+    case 0x4003:
+      write_pulse(apu, &state->pulse[0], addr & 0x03, val);
+      break;
+    case 0x4004:
+    case 0x4005:
+    case 0x4006:
+    case 0x4007:
+      write_pulse(apu, &state->pulse[1], addr & 0x03, val);
+      break;
+    case 0x4008:
+      triangle->control = get_7th_bit(val);
+      triangle->linear_period = val & 0x7F;
+      break;
+    case 0x400A:
+      triangle->timer_period = (triangle->timer_period & 0x0700) | val;
+      break;
+    case 0x400B:
+      triangle->timer_period = (uint16_t)((triangle->timer_period & 0x00FF) | ((val & 0x07) << 8));
+      triangle->length = (state->enabled & 0x04) ? length_table[val >> 3] : triangle->length;
+      triangle->linear_reload = true;
+      break;
+    case 0x400C:
+      noise->envelope.loop = get_5th_bit(val);
+      noise->envelope.constant_volume = val & 0x10;
+      noise->envelope.period = get_lower_4_bits(val);
+      break;
+    case 0x400E:
+      noise->mode = get_7th_bit(val);
+      noise->timer_period = noise_periods[apu->pal][get_lower_4_bits(val)];
+      break;
+    case 0x400F:
+      noise->length = (state->enabled & 0x08) ? length_table[val >> 3] : noise->length;
+      noise->envelope.start = true;
+      break;
+    case 0x4010:
+      dmc->irq_enabled = get_7th_bit(val);
+      dmc->loop = get_6th_bit(val);
+      dmc->rate = dmc_rates[apu->pal][get_lower_4_bits(val)];
+      if (!dmc->irq_enabled) {
+        state->dmc_irq = false;
+        update_irq(apu);
+      }
+      break;
+    case 0x4011:
+      dmc->output = val & 0x7F;
+      break;
+    case 0x4012:
+      dmc->sample_addr = (uint16_t)(0xC000 + val * 64);
+      break;
+    case 0x4013:
+      dmc->sample_length = (uint16_t)(val * 16 + 1);
+      break;
+    case 0x4015:
+      write_status(apu, val);
+      break;
+    case 0x4017:
+      write_frame_counter(apu, val);
+      break;
+    default:
+      return;
+  }
+
+  update_channels(apu);
+  update_output(apu);
+  schedule_dmc(apu);
+}
+
+uint8_t apu_read_status(apu_t *apu) {
+  apu_state_t *state = &apu->state;
+
+  sync(apu);
+  schedule_dmc(apu);
+
+  uint8_t status = 0;
+  status |= state->pulse[0].length > 0 ? 0x01 : 0;
+  status |= state->pulse[1].length > 0 ? 0x02 : 0;
+  status |= state->triangle.length > 0 ? 0x04 : 0;
+  status |= state->noise.length > 0 ? 0x08 : 0;
+  status |= state->dmc.bytes_remaining > 0 ? 0x10 : 0;
+  status |= state->frame_irq ? 0x40 : 0;
+  status |= state->dmc_irq ? 0x80 : 0;
+
+  state->frame_irq = false;
+  update_irq(apu);
+
+  return status | (apu->cpu->bus.open_bus & 0x20);
+}
+
+void apu_power_on(apu_t *apu, cpu_t *cpu, scheduler_t *scheduler) {
+  memset(&apu->state, 0, sizeof(apu->state));
+  memset(apu->deltas, 0, sizeof(apu->deltas));
+  apu->sample_count = 0;
+  apu->skip_audio = false;
+  apu->cpu = cpu;
+  apu->scheduler = scheduler;
+
+  // https://www.nesdev.org/wiki/APU_Mixer, the lookup tables of the nonlinear mixer
+  apu->pulse_mix[0] = 0;
+  for (uint8_t n = 1; n < 31; n++) {
+    apu->pulse_mix[n] = (int16_t)(95.52 / (8128.0 / n + 100.0) * MIX_SCALE + 0.5);
+  }
+  apu->tnd_mix[0] = 0;
+  for (uint8_t n = 1; n < 203; n++) {
+    apu->tnd_mix[n] = (int16_t)(163.67 / (24329.0 / n + 100.0) * MIX_SCALE + 0.5);
+  }
+
+  apu_state_t *state = &apu->state;
+  state->noise.lfsr = 1;
+  state->dmc.bits_remaining = 8;
+  state->dmc.silence = true;
+  state->block_start = cpu->cycles;
+  state->cycle = cpu->cycles;
+  for (uint8_t i = 0; i < 2; i++) {
+    state->pulse[i].next_clock = UINT64_MAX;
+  }
+  state->triangle.next_clock = UINT64_MAX;
+  state->noise.next_clock = UINT64_MAX;
+
+  scheduler_set_handler(scheduler, EVENT_APU_FRAME_COUNTER, on_frame_counter, apu);
+  scheduler_set_handler(scheduler, EVENT_DMC_FETCH, on_dmc_fetch, apu);
+  apu_set_timing(apu, TIMING_NTSC);
+}
+
+// Silences every channel and restarts the frame counter as if $4017 had been written again
+void apu_reset(apu_t *apu) {
+  apu_state_t *state = &apu->state;
+
+  sync(apu);
+  write_status(apu, 0);
+  write_frame_counter(apu, (uint8_t)((state->five_step << 7) | (state->irq_inhibit << 6)));
+  update_channels(apu);
+  update_output(apu);
+  schedule_dmc(apu);
+}
+
+void apu_set_timing(apu_t *apu, cpu_ppu_timing_t timing) {
+  apu_state_t *state = &apu->state;
+
+  // CPU clock rates in Hz as fractions, the master clock is 236.25MHz / 11 on NTSC and
+  // 26.6017125MHz on PAL and Dendy
+  uint64_t rate_numerator = 39375000;
+  uint64_t rate_denominator = 22;
+
+  switch (timing) {
+    case TIMING_PAL:
+      apu->master_clocks_per_cpu_cycle = PAL_MASTER_CLOCKS_PER_CPU_CYCLE;
+      rate_numerator = 53203425;
+      rate_denominator = 32;
+      break;
+    case TIMING_DENDY:
+      apu->master_clocks_per_cpu_cycle = DENDY_MASTER_CLOCKS_PER_CPU_CYCLE;
+      rate_numerator = 53203425;
+      rate_denominator = 30;
+      break;
+    default:
+      apu->master_clocks_per_cpu_cycle = NTSC_MASTER_CLOCKS_PER_CPU_CYCLE;
+  }
+
+  apu->pal = timing == TIMING_PAL;
+  apu->samples_per_cycle = ((uint64_t)APU_SAMPLE_RATE << 32) * rate_denominator / rate_numerator;
+
+  state->noise.timer_period = noise_periods[apu->pal][0];
+  state->dmc.rate = dmc_rates[apu->pal][0];
+  state->dmc.next_clock = state->cycle + state->dmc.rate;
+  write_frame_counter(apu, 0);
+}
+
+// Runs the APU up to `cycle` and turns the block synthesized so far into `samples`. The fraction
+// of a sample left over and the tail of the steps added near the end carry over to the next block.
+void apu_end_frame(apu_t *apu, uint64_t cycle) {
+  apu_state_t *state = &apu->state;
+  profile_component_t previous = profile_enter(PROFILE_APU);
+
+  run_until(apu, cycle);
+  schedule_dmc(apu);
+
+  uint64_t position = (cycle - state->block_start) * apu->samples_per_cycle + state->block_offset;
+  size_t count = position >> 32;
+  count = count < APU_MAX_BLOCK_SAMPLES ? count : APU_MAX_BLOCK_SAMPLES;
+
+  for (size_t i = 0; i < count; i++) {
+    state->integrator += apu->deltas[i];
+    int32_t in = state->integrator >> 15;
+    int32_t feedback = (int32_t)(((int64_t)state->highpass_out * HIGHPASS_R) >> 15);
+    int32_t out = in - state->highpass_in + feedback;
+
+    state->highpass_in = in;
+    state->highpass_out = out;
+    apu->samples[i] = (int16_t)(out < INT16_MIN ? INT16_MIN : out > INT16_MAX ? INT16_MAX : out);
+  }
+
+  memmove(apu->deltas, apu->deltas + count, APU_KERNEL_TAPS * sizeof(apu->deltas[0]));
+  memset(apu->deltas + APU_KERNEL_TAPS, 0, count * sizeof(apu->deltas[0]));
+
+  apu->sample_count = count;
+  state->block_start = cycle;
+  state->block_offset = position & 0xFFFFFFFF;
+  profile_leave(previous);
+}
+
+void apu_set_skip_audio(apu_t *apu, bool skip) {
+  sync(apu);
+  apu->skip_audio = skip;
+  update_channels(apu);
+}
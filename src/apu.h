@@ -0,0 +1,142 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cpu.h"
+#include "load_rom.h"
+#include "scheduler.h"
+
+static constexpr uint32_t APU_SAMPLE_RATE = 48000;
+static constexpr size_t APU_MAX_BLOCK_SAMPLES = 4096;
+static constexpr size_t APU_KERNEL_TAPS = 16;
+
+typedef struct {
+  bool start;
+  bool loop;  // also halts the length counter
+  bool constant_volume;
+  uint8_t period;  // the volume if constant_volume is set
+  uint8_t divider;
+  uint8_t decay;
+} envelope_t;
+
+typedef struct {
+  envelope_t envelope;
+  uint8_t duty;
+  uint8_t sequence;
+  bool sweep_enabled;
+  bool sweep_negate;
+  bool sweep_reload;
+  uint8_t sweep_period;
+  uint8_t sweep_shift;
+  uint8_t sweep_divider;
+  uint16_t timer_period;
+  uint8_t length;
+  uint8_t volume;       // 0 while muted, see update_channels()
+  uint64_t next_clock;  // CPU cycle of the next timer clock, UINT64_MAX while silent
+} pulse_t;
+
+typedef struct {
+  bool control;  // also halts the length counter
+  bool linear_reload;
+  uint8_t linear_period;
+  uint8_t linear_counter;
+  uint16_t timer_period;
+  uint8_t sequence;
+  uint8_t length;
+  uint64_t next_clock;
+} triangle_t;
+
+typedef struct {
+  envelope_t envelope;
+  bool mode;
+  uint16_t lfsr;
+  uint16_t timer_period;  // in CPU cycles
+  uint8_t length;
+  uint8_t volume;
+  uint64_t next_clock;
+} noise_t;
+
+typedef struct {
+  bool irq_enabled;
+  bool loop;
+  uint16_t rate;  // in CPU cycles
+  uint8_t output;
+  uint16_t sample_addr;
+  uint16_t sample_length;
+  uint16_t current_addr;
+  uint16_t bytes_remaining;
+  uint8_t buffer;
+  bool buffer_full;
+  uint8_t shift;
+  uint8_t bits_remaining;
+  bool silence;
+  uint64_t next_clock;
+} dmc_t;
+
+typedef struct {
+  pulse_t pulse[2];
+  triangle_t triangle;
+  noise_t noise;
+  dmc_t dmc;
+  uint8_t enabled;  // $4015
+
+  bool five_step;
+  bool irq_inhibit;
+  bool frame_irq;
+  bool dmc_irq;
+  uint8_t frame_step;
+  uint64_t frame_start;  // CPU cycle the current frame counter sequence started at
+
+  uint64_t cycle;  // CPU cycle the channels have been run up to
+  int32_t mix;     // mixer output at `cycle`
+
+  // the block of samples being synthesized, positions are 32.32 fixed point sample offsets
+  uint64_t block_start;
+  uint64_t block_offset;
+  int32_t integrator;
+  int32_t highpass_in;
+  int32_t highpass_out;
+} apu_state_t;
+
+typedef struct {
+  apu_state_t state;
+
+  // band-limited steps of the current block, integrated into `samples` by apu_end_frame()
+  int32_t deltas[APU_MAX_BLOCK_SAMPLES + APU_KERNEL_TAPS];
+  int16_t samples[APU_MAX_BLOCK_SAMPLES];
+  size_t sample_count;
+
+  int16_t pulse_mix[31];
+  int16_t tnd_mix[203];
+
+  cpu_t *cpu;
+  scheduler_t *scheduler;
+  uint64_t master_clocks_per_cpu_cycle;
+  uint64_t samples_per_cycle;  // 32.32 fixed point
+  bool pal;
+  bool skip_audio;  // only the DMC is clocked, see update_channels()
+} apu_t;
+
+void apu_power_on(apu_t *apu, cpu_t *cpu, scheduler_t *scheduler);
+void apu_reset(apu_t *apu);
+void apu_set_timing(apu_t *apu, cpu_ppu_timing_t timing);
+uint8_t apu_read_status(apu_t *apu);
+void apu_write_register(apu_t *apu, uint16_t addr, uint8_t val);
+void apu_end_frame(apu_t *apu, uint64_t cycle);
+void apu_set_skip_audio(apu_t *apu, bool skip);
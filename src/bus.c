@@ -0,0 +1,75 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#include "bus.h"
+
+#include "utils.h"
+
+private
+uint8_t read_open_bus(void *ctx, uint16_t addr) {
+  (void)addr;
+  return ((bus_t *)ctx)->open_bus;
+}
+
+private
+void write_nothing(void *ctx, uint16_t addr, uint8_t val) {
+  (void)ctx;
+  (void)addr;
+  (void)val;
+}
+
+void bus_init(bus_t *bus) {
+  bus->open_bus = 0;
+  bus_unmap(bus, 0x0000, 0xFFFF);
+}
+
+// `mem` is mirrored over [start, end] if it is smaller than the range. Both `start` and
+// `mem_size` have to be multiples of BUS_PAGE_SIZE.
+void bus_map_read_memory(bus_t *bus, uint16_t start, uint16_t end, const uint8_t *mem,
+                         size_t mem_size) {
+  for (uint32_t addr = start; addr <= end; addr += BUS_PAGE_SIZE) {
+    bus->read_pages[addr >> 8] = mem + (addr - start) % mem_size;
+  }
+}
+
+void bus_map_write_memory(bus_t *bus, uint16_t start, uint16_t end, uint8_t *mem, size_t mem_size) {
+  for (uint32_t addr = start; addr <= end; addr += BUS_PAGE_SIZE) {
+    bus->write_pages[addr >> 8] = mem + (addr - start) % mem_size;
+  }
+}
+
+void bus_map_read_handler(bus_t *bus, uint16_t start, uint16_t end, bus_read_handler_t handler,
+                          void *ctx) {
+  for (uint32_t addr = start; addr <= end; addr += BUS_PAGE_SIZE) {
+    bus->read_pages[addr >> 8] = nullptr;
+    bus->read_handlers[addr >> 8] = handler;
+    bus->read_ctx[addr >> 8] = ctx;
+  }
+}
+
+void bus_map_write_handler(bus_t *bus, uint16_t start, uint16_t end, bus_write_handler_t handler,
+                           void *ctx) {
+  for (uint32_t addr = start; addr <= end; addr += BUS_PAGE_SIZE) {
+    bus->write_pages[addr >> 8] = nullptr;
+    bus->write_handlers[addr >> 8] = handler;
+    bus->write_ctx[addr >> 8] = ctx;
+  }
+}
+
+// Unmapped pages read back the open bus value and ignore writes
+void bus_unmap(bus_t *bus, uint16_t start, uint16_t end) {
+  bus_map_read_handler(bus, start, end, read_open_bus, bus);
+  bus_map_write_handler(bus, start, end, write_nothing, nullptr);
+}
@@ -0,0 +1,74 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The CPU address space is split into 256 pages of 256 bytes. A page is either backed directly by
+// memory (RAM, PRG ROM, PRG RAM), in which case an access is a single indexed load or store, or
+// it is memory mapped I/O and the access goes through a handler. Reads and writes are mapped
+// separately, so that e.g. PRG ROM can be read directly while writes to it reach the mapper.
+static constexpr uint16_t BUS_PAGE_COUNT = 256;
+static constexpr uint16_t BUS_PAGE_SIZE = 256;
+
+typedef enum { BUS_READ, BUS_WRITE } bus_access_t;
+
+typedef uint8_t (*bus_read_handler_t)(void *ctx, uint16_t addr);
+typedef void (*bus_write_handler_t)(void *ctx, uint16_t addr, uint8_t val);
+
+typedef struct {
+  const uint8_t *read_pages[BUS_PAGE_COUNT];  // nullptr if the page is handled by read_handlers
+  uint8_t *write_pages[BUS_PAGE_COUNT];       // nullptr if the page is handled by write_handlers
+  bus_read_handler_t read_handlers[BUS_PAGE_COUNT];
+  bus_write_handler_t write_handlers[BUS_PAGE_COUNT];
+  void *read_ctx[BUS_PAGE_COUNT];
+  void *write_ctx[BUS_PAGE_COUNT];
+  uint8_t open_bus;  // last value driven on the data bus, returned by unmapped reads
+} bus_t;
+
+void bus_init(bus_t *bus);
+void bus_map_read_memory(bus_t *bus, uint16_t start, uint16_t end, const uint8_t *mem,
+                         size_t mem_size);
+void bus_map_write_memory(bus_t *bus, uint16_t start, uint16_t end, uint8_t *mem, size_t mem_size);
+void bus_map_read_handler(bus_t *bus, uint16_t start, uint16_t end, bus_read_handler_t handler,
+                          void *ctx);
+void bus_map_write_handler(bus_t *bus, uint16_t start, uint16_t end, bus_write_handler_t handler,
+                           void *ctx);
+void bus_unmap(bus_t *bus, uint16_t start, uint16_t end);
+
+static inline uint8_t bus_read(bus_t *bus, uint16_t addr) {
+  uint8_t page = (uint8_t)(addr >> 8);
+  const uint8_t *mem = bus->read_pages[page];
+
+  if (mem) {
+    return mem[addr & 0xFF];
+  }
+
+  return bus->read_handlers[page](bus->read_ctx[page], addr);
+}
+
+static inline void bus_write(bus_t *bus, uint16_t addr, uint8_t val) {
+  uint8_t page = (uint8_t)(addr >> 8);
+  uint8_t *mem = bus->write_pages[page];
+
+  if (mem) {
+    mem[addr & 0xFF] = val;
+    return;
+  }
+
+  bus->write_handlers[page](bus->write_ctx[page], addr, val);
+}
@@ -0,0 +1,118 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#include "bus_trace.h"
+
+#include <string.h>
+
+#include "utils.h"
+
+static constexpr char BUS_TRACE_MAGIC[4] = {'N', 'B', 'T', 'R'};
+static constexpr uint32_t BUS_TRACE_VERSION = 1;
+static constexpr size_t DECODE_CHUNK_SIZE = 4096;
+
+typedef struct {
+  char magic[4];
+  uint32_t version;
+  uint64_t now;
+  uint64_t count;
+} bus_trace_file_header_t;
+
+bool bus_trace_init(arena_t *arena, bus_trace_t *trace, size_t capacity) {
+  return_value_if(capacity == 0, false, "Bus trace capacity cannot be zero");
+
+  size_t rounded_capacity = 1;
+  while (rounded_capacity < capacity) {
+    return_value_if(rounded_capacity > SIZE_MAX / 2, false, ERR_ARITHMETIC_OVERFLOW);
+    rounded_capacity <<= 1;
+  }
+
+  // the entries are only ever read back up to count, so they do not need to be zeroed
+  trace->entries = new (arena, uint64_t, rounded_capacity, NOZERO);
+  return_value_if(trace->entries == nullptr, false,
+                  "Not enough memory for a bus trace of %zu entries", rounded_capacity);
+
+  trace->mask = rounded_capacity - 1;
+  trace->count = 0;
+
+  return true;
+}
+
+bool bus_trace_dump(const bus_trace_t *trace, uint64_t now, const char *file_path) {
+  return_value_if(file_path == nullptr, false, ERR_NULL_FILEPATH);
+
+  FILE *dump_filep __attribute__((cleanup(cleanup_file))) = fopen(file_path, "wb");
+  return_value_if(dump_filep == nullptr, false, "cannot open file: %s", file_path);
+
+  size_t capacity = trace->mask + 1;
+  size_t stored = trace->count < capacity ? trace->count : capacity;
+  size_t oldest = trace->count < capacity ? 0 : trace->count & trace->mask;
+
+  bus_trace_file_header_t header = {.version = BUS_TRACE_VERSION, .now = now, .count = stored};
+  memcpy(header.magic, BUS_TRACE_MAGIC, sizeof(header.magic));
+
+  return_value_if(fwrite(&header, sizeof(header), 1, dump_filep) != 1, false,
+                  "cannot write file: %s", file_path);
+
+  // write the entries from the oldest to the newest one, unrolling the ring in at most two runs
+  size_t first_run = capacity - oldest < stored ? capacity - oldest : stored;
+  return_value_if(fwrite(trace->entries + oldest, sizeof(uint64_t), first_run, dump_filep) !=
+                      first_run,
+                  false, "cannot write file: %s", file_path);
+  return_value_if(fwrite(trace->entries, sizeof(uint64_t), stored - first_run, dump_filep) !=
+                      stored - first_run,
+                  false, "cannot write file: %s", file_path);
+
+  return true;
+}
+
+bool bus_trace_decode(FILE *in, FILE *out, bool show_access_kind) {
+  bus_trace_file_header_t header;
+
+  return_value_if(fread(&header, sizeof(header), 1, in) != 1, false, "Truncated bus trace header");
+  return_value_if(memcmp(header.magic, BUS_TRACE_MAGIC, sizeof(header.magic)) != 0, false,
+                  "Not a bus trace dump");
+  return_value_if(header.version != BUS_TRACE_VERSION, false,
+                  "Unsupported bus trace version: %u", header.version);
+
+  const uint64_t cycle_mask = (UINT64_C(1) << BUS_TRACE_CYCLE_BITS) - 1;
+  uint64_t entries[DECODE_CHUNK_SIZE];
+  uint64_t remaining = header.count;
+
+  while (remaining > 0) {
+    size_t chunk = remaining < DECODE_CHUNK_SIZE ? remaining : DECODE_CHUNK_SIZE;
+    return_value_if(fread(entries, sizeof(uint64_t), chunk, in) != chunk, false,
+                    "Truncated bus trace, %lu entries missing", remaining);
+
+    for (size_t i = 0; i < chunk; i++) {
+      uint64_t entry = entries[i];
+      uint64_t low_cycle = entry >> BUS_TRACE_CYCLE_SHIFT;
+      uint64_t cycle = header.now - ((header.now - low_cycle) & cycle_mask);
+      uint16_t addr = (uint16_t)entry;
+      uint8_t val = (uint8_t)(entry >> BUS_TRACE_VALUE_SHIFT);
+      bus_access_t kind = (entry >> BUS_TRACE_KIND_SHIFT) & 1;
+
+      fprintf(out, "MEM[%d]=%d CYC:%ld", addr, val, cycle);
+      if (show_access_kind) {
+        fputs(kind == BUS_WRITE ? " write" : " read", out);
+      }
+      fputc('\n', out);
+    }
+
+    remaining -= chunk;
+  }
+
+  return true;
+}
@@ -0,0 +1,57 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "alloc.h"
+#include "bus.h"
+
+// Binary ring buffer of CPU bus accesses, enabled at compile time with -DBUS_TRACE.
+//
+// Every entry is packed into a single 64 bit word so that recording a bus cycle is one store:
+//
+//   bits 0-15   address
+//   bits 16-23  value
+//   bit  24     bus_access_t
+//   bits 25-63  lower 39 bits of the cycle counter
+//
+// 39 bits of cycles is about 3.5 days of NTSC CPU time. The dump header stores the full cycle
+// counter at the time of the dump and the decoder reconstructs the upper bits from it.
+
+static constexpr uint8_t BUS_TRACE_CYCLE_SHIFT = 25;
+static constexpr uint8_t BUS_TRACE_KIND_SHIFT = 24;
+static constexpr uint8_t BUS_TRACE_VALUE_SHIFT = 16;
+static constexpr uint8_t BUS_TRACE_CYCLE_BITS = 39;
+
+typedef struct {
+  uint64_t *entries;
+  size_t mask;   // capacity - 1, capacity is always a power of two
+  size_t count;  // total number of recorded accesses, the next slot is count & mask
+} bus_trace_t;
+
+[[nodiscard]] bool bus_trace_init(arena_t *arena, bus_trace_t *trace, size_t capacity);
+[[nodiscard]] bool bus_trace_dump(const bus_trace_t *trace, uint64_t now, const char *file_path);
+[[nodiscard]] bool bus_trace_decode(FILE *in, FILE *out, bool show_access_kind);
+
+static inline void bus_trace_record(bus_trace_t *trace, uint64_t cycle, uint16_t addr, uint8_t val,
+                                    bus_access_t kind) {
+  trace->entries[trace->count++ & trace->mask] =
+      (cycle << BUS_TRACE_CYCLE_SHIFT) | ((uint64_t)kind << BUS_TRACE_KIND_SHIFT) |
+      ((uint64_t)val << BUS_TRACE_VALUE_SHIFT) | addr;
+}
@@ -0,0 +1,135 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#include "chr_decode.h"
+
+#include "utils.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__SSE2__))
+#define CHR_DECODE_X86
+#include <immintrin.h>
+#endif
+
+// Byte i of the result holds bit 7 - i of `plane`: the multiplication places a copy of `plane` at
+// every 9th bit, so that bit 7 of byte i lines up with bit 7 - i of its copy. The copies do not
+// overlap and thus never carry into each other.
+private
+uint64_t spread_bits(uint8_t plane) {
+  return ((plane * 0x8040201008040201) & 0x8080808080808080) >> 7;
+}
+
+private
+uint64_t to_little_endian(uint64_t row) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return __builtin_bswap64(row);
+#else
+  return row;
+#endif
+}
+
+[[maybe_unused]] private
+void decode_scalar(uint64_t *out, const uint8_t *chr, size_t tile_count) {
+  for (size_t tile = 0; tile < tile_count; tile++, chr += CHR_TILE_SIZE) {
+    for (uint8_t row = 0; row < CHR_TILE_ROWS; row++) {
+      uint64_t pixels = spread_bits(chr[row]) | (spread_bits(chr[row + CHR_TILE_ROWS]) << 1);
+      *out++ = to_little_endian(pixels);
+    }
+  }
+}
+
+#ifdef CHR_DECODE_X86
+
+// `lo` and `hi` hold two rows of a bitplane, each repeated 8 times. Masking every copy with a
+// different bit and comparing it to that bit turns the row into one byte per pixel.
+private
+__m128i decode_rows_sse2(__m128i lo, __m128i hi) {
+  const __m128i bits = _mm_set1_epi64x(0x0102040810204080);
+
+  lo = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(lo, bits), bits), _mm_set1_epi8(1));
+  hi = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(hi, bits), bits), _mm_set1_epi8(2));
+  return _mm_or_si128(lo, hi);
+}
+
+private
+void decode_sse2(uint64_t *out, const uint8_t *chr, size_t tile_count) {
+  for (size_t tile = 0; tile < tile_count; tile++, chr += CHR_TILE_SIZE, out += CHR_TILE_ROWS) {
+    // repeat every row byte 8 times with three rounds of unpacking
+    __m128i lo = _mm_loadl_epi64((const __m128i *)chr);
+    __m128i hi = _mm_loadl_epi64((const __m128i *)(chr + CHR_TILE_ROWS));
+    lo = _mm_unpacklo_epi8(lo, lo);
+    hi = _mm_unpacklo_epi8(hi, hi);
+
+    __m128i lo_0_3 = _mm_unpacklo_epi16(lo, lo);
+    __m128i hi_0_3 = _mm_unpacklo_epi16(hi, hi);
+    __m128i lo_4_7 = _mm_unpackhi_epi16(lo, lo);
+    __m128i hi_4_7 = _mm_unpackhi_epi16(hi, hi);
+
+    __m128i *dst = (__m128i *)out;
+    _mm_storeu_si128(dst, decode_rows_sse2(_mm_unpacklo_epi32(lo_0_3, lo_0_3),
+                                           _mm_unpacklo_epi32(hi_0_3, hi_0_3)));
+    _mm_storeu_si128(dst + 1, decode_rows_sse2(_mm_unpackhi_epi32(lo_0_3, lo_0_3),
+                                               _mm_unpackhi_epi32(hi_0_3, hi_0_3)));
+    _mm_storeu_si128(dst + 2, decode_rows_sse2(_mm_unpacklo_epi32(lo_4_7, lo_4_7),
+                                               _mm_unpacklo_epi32(hi_4_7, hi_4_7)));
+    _mm_storeu_si128(dst + 3, decode_rows_sse2(_mm_unpackhi_epi32(lo_4_7, lo_4_7),
+                                               _mm_unpackhi_epi32(hi_4_7, hi_4_7)));
+  }
+}
+
+// Same as the SSE2 version, but one shuffle repeats four rows at once
+[[gnu::target("avx2")]] private
+void decode_avx2(uint64_t *out, const uint8_t *chr, size_t tile_count) {
+  const __m256i bits = _mm256_set1_epi64x(0x0102040810204080);
+  const __m256i rows_0_3 = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                            2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+  const __m256i rows_4_7 = _mm256_add_epi8(rows_0_3, _mm256_set1_epi8(4));
+
+  for (size_t tile = 0; tile < tile_count; tile++, chr += CHR_TILE_SIZE, out += CHR_TILE_ROWS) {
+    uint64_t lo_plane;
+    uint64_t hi_plane;
+    memcpy(&lo_plane, chr, sizeof(lo_plane));
+    memcpy(&hi_plane, chr + CHR_TILE_ROWS, sizeof(hi_plane));
+
+    // the shuffle works within 128 bit lanes, so every lane gets the whole plane
+    __m256i lo = _mm256_set1_epi64x((long long)lo_plane);
+    __m256i hi = _mm256_set1_epi64x((long long)hi_plane);
+
+    for (uint8_t half = 0; half < 2; half++) {
+      __m256i rows = half ? rows_4_7 : rows_0_3;
+      __m256i lo_rows = _mm256_shuffle_epi8(lo, rows);
+      __m256i hi_rows = _mm256_shuffle_epi8(hi, rows);
+
+      lo_rows = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(lo_rows, bits), bits),
+                                 _mm256_set1_epi8(1));
+      hi_rows = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(hi_rows, bits), bits),
+                                 _mm256_set1_epi8(2));
+      _mm256_storeu_si256((__m256i *)(out + 4 * half), _mm256_or_si256(lo_rows, hi_rows));
+    }
+  }
+}
+
+#endif
+
+void chr_decode_tiles(uint64_t *out, const uint8_t *chr, size_t tile_count) {
+#ifdef CHR_DECODE_X86
+  if (__builtin_cpu_supports("avx2")) {
+    decode_avx2(out, chr, tile_count);
+  } else {
+    decode_sse2(out, chr, tile_count);
+  }
+#else
+  decode_scalar(out, chr, tile_count);
+#endif
+}
@@ -0,0 +1,28 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A CHR tile is 8x8 pixels stored as two bitplanes: 8 bytes holding bit 0 of every row followed by
+// 8 bytes holding bit 1, the leftmost pixel in the most significant bit. Decoding turns every row
+// into 8 bytes, one 2 bit color per pixel with the leftmost pixel first in memory, so that the
+// renderer can copy a row of a tile instead of extracting it bit by bit.
+static constexpr size_t CHR_TILE_SIZE = 16;
+static constexpr size_t CHR_TILE_ROWS = 8;
+
+void chr_decode_tiles(uint64_t *out, const uint8_t *chr, size_t tile_count);
@@ -0,0 +1,39 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#include "controller.h"
+
+#include "utils.h"
+
+// $4016, bit 0 is the strobe of both ports
+void controllers_write(controllers_t *controllers, uint8_t val) {
+  controllers->strobe = check_if_bit0_set(val);
+  if (controllers->strobe) {
+    controllers->shift[0] = controllers->buttons[0];
+    controllers->shift[1] = controllers->buttons[1];
+  }
+}
+
+// $4016 for port 0 and $4017 for port 1, returns bit 0 only. After the eight buttons an official
+// controller returns 1.
+uint8_t controllers_read(controllers_t *controllers, uint8_t port) {
+  if (controllers->strobe) {
+    return get_0th_bit(controllers->buttons[port]);
+  }
+
+  uint8_t bit = get_0th_bit(controllers->shift[port]);
+  controllers->shift[port] = (controllers->shift[port] >> 1) | 0x80;
+  return bit;
+}
@@ -0,0 +1,40 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#pragma once
+
+#include <stdint.h>
+
+// The two standard controllers, https://www.nesdev.org/wiki/Standard_controller
+typedef enum {
+  BUTTON_A = 1 << 0,
+  BUTTON_B = 1 << 1,
+  BUTTON_SELECT = 1 << 2,
+  BUTTON_START = 1 << 3,
+  BUTTON_UP = 1 << 4,
+  BUTTON_DOWN = 1 << 5,
+  BUTTON_LEFT = 1 << 6,
+  BUTTON_RIGHT = 1 << 7,
+} button_t;
+
+// Free of pointers so that it can be copied as is
+typedef struct {
+  uint8_t buttons[2];  // button_t bitmasks of what is held down, set by the frontend
+  uint8_t shift[2];    // the buttons latched by the last strobe, read out from bit 0 up
+  bool strobe;         // the shift registers keep reloading while it is set
+} controllers_t;
+
+void controllers_write(controllers_t *controllers, uint8_t val);
+uint8_t controllers_read(controllers_t *controllers, uint8_t port);
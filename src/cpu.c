@@ -18,12 +18,20 @@ You should have received a copy of the GNU General Public License along with nem
 
 #include <stdint.h>
 
+#include "bus_trace.h"
+#include "trace.h"
 #include "utils.h"
 
 #define STACK_ADDR ((uint16_t)cpu->sp + 0x100)
 
 static constexpr uint8_t LXA_XAA_MAGIC = 0xEE;
 
+#ifdef NES_STATS
+#define stats_count(cpu, counter) ((cpu)->stats.counter++)
+#else
+#define stats_count(cpu, counter) ((void)(cpu))
+#endif
+
 static constexpr uint8_t INTERRUPT_DISABLE = 1 << 2;
 static constexpr uint8_t B = 1 << 4;
 static constexpr uint8_t UNUSED = 1 << 5;
@@ -63,11 +71,12 @@ static const char *addressing_modes_string[] = {
     "NONE",      "RELATIVE",   "ZERO_PAGE",  "ZERO_PAGE_X", "ZERO_PAGE_Y"};
 
 private
-uint8_t read(cpu_t *cpu, uint16_t addr) { return cpu->mem[addr]; }
+uint8_t read(cpu_t *cpu, uint16_t addr) { return bus_read(&cpu->bus, addr); }
 private
-void write(cpu_t *cpu, uint16_t addr, uint8_t val) { cpu->mem[addr] = val; }
+void write(cpu_t *cpu, uint16_t addr, uint8_t val) { bus_write(&cpu->bus, addr, val); }
 
 #define GET_MACRO(_1, _2, NAME, ...) NAME
+#define GET_MACRO_3(_1, _2, _3, NAME, ...) NAME
 
 #define mem_read_byte(...) \
   GET_MACRO(__VA_ARGS__, mem_read_byte_from_addr, mem_read_byte_from_pc)(__VA_ARGS__)
@@ -75,10 +84,36 @@ void write(cpu_t *cpu, uint16_t addr, uint8_t val) { cpu->mem[addr] = val; }
 #define mem_read_word(...) \
   GET_MACRO(__VA_ARGS__, mem_read_word_from_addr, mem_read_word_from_pc)(__VA_ARGS__)
 
+// Every bus access takes exactly one cycle, keep the cycle counting and per-cycle tracing here so
+// that the memory helpers below stay free of any logging code
+private
+void tick(cpu_t *cpu, uint16_t addr, uint8_t val, bus_access_t kind) {
+  cpu->cycles++;
+  cpu->bus.open_bus = val;
+  trace_cycle("MEM[%d]=%d CYC:%ld", addr, val, cpu->cycles);
+
+#ifdef BUS_TRACE
+  if (cpu->bus_trace) {
+    bus_trace_record(cpu->bus_trace, cpu->cycles, addr, val, kind);
+  }
+#endif
+#ifdef CPU_BUS_LOG
+  cpu_bus_log_t *log = &cpu->bus_log;
+  if (log->count < CPU_BUS_LOG_CAPACITY) {
+    log->accesses[log->count] = (cpu_bus_access_t){.addr = addr, .val = val, .kind = kind};
+  }
+  log->count++;
+#endif
+#if !defined(BUS_TRACE) && !defined(CPU_BUS_LOG)
+  (void)kind;
+#endif
+}
+
 private
 uint8_t mem_read_byte_from_pc(cpu_t *cpu) {
-  uint8_t val = read(cpu, cpu->pc);
-  log_info("MEM[%d]=%d CYC:%ld", cpu->pc++, val, ++cpu->cycles);
+  uint16_t addr = cpu->pc++;
+  uint8_t val = read(cpu, addr);
+  tick(cpu, addr, val, BUS_READ);
   return val;
 }
 
@@ -93,7 +128,7 @@ uint16_t mem_read_word_from_pc(cpu_t *cpu) {
 private
 uint8_t mem_read_byte_from_addr(cpu_t *cpu, uint16_t addr) {
   uint8_t val = read(cpu, addr);
-  log_info("MEM[%d]=%d CYC:%ld", addr, val, ++cpu->cycles);
+  tick(cpu, addr, val, BUS_READ);
   return val;
 }
 
@@ -108,7 +143,21 @@ uint16_t mem_read_word_from_addr(cpu_t *cpu, uint16_t addr) {
 private
 void mem_write_byte(cpu_t *cpu, uint16_t addr, uint8_t val) {
   write(cpu, addr, val);
-  log_info("MEM[%d]=%d CYC:%ld", addr, val, ++cpu->cycles);
+  tick(cpu, addr, val, BUS_WRITE);
+}
+
+// Accesses whose value is thrown away, or that write back the value just read, the 6502 makes
+// one on every cycle that it has nothing else to do on the bus
+private
+void dummy_read_byte(cpu_t *cpu, uint16_t addr) {
+  stats_count(cpu, dummy_reads);
+  mem_read_byte(cpu, addr);
+}
+
+private
+void dummy_write_byte(cpu_t *cpu, uint16_t addr, uint8_t val) {
+  stats_count(cpu, dummy_writes);
+  mem_write_byte(cpu, addr, val);
 }
 
 private
@@ -117,7 +166,7 @@ void push_byte(cpu_t *cpu, uint8_t val) {
   write(cpu, addr, val);
 
   cpu->sp--;  // stack grows downwards
-  log_info("MEM[%d]=%d CYC:%ld", addr, val, ++cpu->cycles);
+  tick(cpu, addr, val, BUS_WRITE);
 }
 
 private
@@ -134,7 +183,8 @@ uint8_t peek_byte(cpu_t *cpu) {
   uint16_t addr = STACK_ADDR;
   uint8_t val = read(cpu, addr);
 
-  log_info("MEM[%d]=%d CYC:%ld", addr, val, ++cpu->cycles);
+  stats_count(cpu, dummy_reads);
+  tick(cpu, addr, val, BUS_READ);
   return val;
 }
 
@@ -143,7 +193,7 @@ uint8_t pop_byte(cpu_t *cpu) {
   cpu->sp++;
   uint16_t addr = STACK_ADDR;
   uint8_t val = read(cpu, addr);
-  log_info("MEM[%d]=%d CYC:%ld", addr, val, ++cpu->cycles);
+  tick(cpu, addr, val, BUS_READ);
   return val;
 }
 
@@ -169,7 +219,10 @@ uint16_t fetch_absolute_x(cpu_t *cpu, bool dummy_read) {
   bool page_crossed = check_page_crossed(base_addr, cpu->x);
 
   if (page_crossed || dummy_read) {
-    mem_read_byte(cpu, (uint16_t)(base_addr + cpu->x - (page_crossed << 8)));
+    dummy_read_byte(cpu, (uint16_t)(base_addr + cpu->x - (page_crossed << 8)));
+  }
+  if (page_crossed && !dummy_read) {
+    stats_count(cpu, page_crossings);
   }
 
   return base_addr + cpu->x;
@@ -181,7 +234,10 @@ uint16_t fetch_absolute_y(cpu_t *cpu, bool dummy_read) {
   bool page_crossed = check_page_crossed(base_addr, cpu->y);
 
   if (page_crossed || dummy_read) {
-    mem_read_byte(cpu, (uint16_t)(base_addr + cpu->y - (page_crossed << 8)));
+    dummy_read_byte(cpu, (uint16_t)(base_addr + cpu->y - (page_crossed << 8)));
+  }
+  if (page_crossed && !dummy_read) {
+    stats_count(cpu, page_crossings);
   }
 
   return base_addr + cpu->y;
@@ -189,7 +245,7 @@ uint16_t fetch_absolute_y(cpu_t *cpu, bool dummy_read) {
 
 private
 uint16_t fetch_accumulator(cpu_t *cpu) {
-  mem_read_byte(cpu, cpu->pc);  // dummy read
+  dummy_read_byte(cpu, cpu->pc);
   return 0;
 }
 
@@ -198,7 +254,7 @@ uint16_t fetch_immediate(cpu_t *cpu) { return mem_read_byte(cpu); }
 
 private
 uint16_t fetch_implicit(cpu_t *cpu) {
-  mem_read_byte(cpu, cpu->pc);  // dummy read
+  dummy_read_byte(cpu, cpu->pc);
   return 0;
 }
 
@@ -219,7 +275,7 @@ uint16_t fetch_indirect(cpu_t *cpu) {
 private
 uint16_t fetch_indirect_x(cpu_t *cpu) {
   uint16_t zp_addr = mem_read_byte(cpu);
-  mem_read_byte(cpu, zp_addr);  // dummy read
+  dummy_read_byte(cpu, zp_addr);
 
   uint16_t old_addr = (zp_addr + cpu->x) & ZP_WRAPAROUND_ADDR;
 
@@ -247,7 +303,10 @@ uint16_t fetch_indirect_y(cpu_t *cpu, bool dummy_read) {
 
   bool page_crossed = check_page_crossed(addr, cpu->y);
   if (page_crossed || dummy_read) {
-    mem_read_byte(cpu, (uint16_t)(addr + cpu->y - (page_crossed << 8)));
+    dummy_read_byte(cpu, (uint16_t)(addr + cpu->y - (page_crossed << 8)));
+  }
+  if (page_crossed && !dummy_read) {
+    stats_count(cpu, page_crossings);
   }
 
   return addr + cpu->y;
@@ -259,20 +318,20 @@ uint8_t fetch_zero_page(cpu_t *cpu) { return mem_read_byte(cpu); }
 private
 uint8_t fetch_zero_page_x(cpu_t *cpu) {
   uint8_t zp_addr = mem_read_byte(cpu);
-  mem_read_byte(cpu, zp_addr);
+  dummy_read_byte(cpu, zp_addr);
   return zp_addr + cpu->x;
 }
 
 private
 uint8_t fetch_zero_page_y(cpu_t *cpu) {
   uint8_t zp_addr = mem_read_byte(cpu);
-  mem_read_byte(cpu, zp_addr);
+  dummy_read_byte(cpu, zp_addr);
   return zp_addr + cpu->y;
 }
 
 private
-uint16_t fetch_address(cpu_t *cpu) {
-  switch (cpu->current_addr_mode) {
+uint16_t fetch_address(cpu_t *cpu, addressing_modes_t mode) {
+  switch (mode) {
     case ADDRESSING_ABSOLUTE:
       return fetch_absolute(cpu);
     case ADDRESSING_ABSOLUTE_X:
@@ -317,12 +376,12 @@ uint16_t fetch_address(cpu_t *cpu) {
    (mode) == ADDRESSING_IMPLICIT || (mode) == ADDRESSING_ACCUMULATOR)
 
 #define fetch_operand(...) \
-  GET_MACRO(__VA_ARGS__, fetch_operand_from_addr, fetch_operand_auto)(__VA_ARGS__)
+  GET_MACRO_3(__VA_ARGS__, fetch_operand_from_addr, fetch_operand_auto, _)(__VA_ARGS__)
 
 private
-uint8_t fetch_operand_auto(cpu_t *cpu) {
-  uint16_t addr = fetch_address(cpu);
-  if (is_direct_value_mode(cpu->current_addr_mode)) {
+uint8_t fetch_operand_auto(cpu_t *cpu, addressing_modes_t mode) {
+  uint16_t addr = fetch_address(cpu, mode);
+  if (is_direct_value_mode(mode)) {
     return (uint8_t)addr;
   } else {
     return mem_read_byte(cpu, addr);
@@ -330,8 +389,8 @@ uint8_t fetch_operand_auto(cpu_t *cpu) {
 }
 
 private
-uint8_t fetch_operand_from_addr(cpu_t *cpu, uint16_t addr) {
-  if (is_direct_value_mode(cpu->current_addr_mode)) {
+uint8_t fetch_operand_from_addr(cpu_t *cpu, addressing_modes_t mode, uint16_t addr) {
+  if (is_direct_value_mode(mode)) {
     return (uint8_t)addr;
   } else {
     return mem_read_byte(cpu, addr);
@@ -359,32 +418,32 @@ void ADD(cpu_t *cpu, uint8_t val) {
 }
 
 private
-void ADC(cpu_t *cpu) { ADD(cpu, fetch_operand(cpu)); }
+void ADC(cpu_t *cpu, addressing_modes_t mode) { ADD(cpu, fetch_operand(cpu, mode)); }
 
 // FIXME: later
 private
-void AHX(cpu_t *cpu) {
-  uint16_t addr = fetch_address(cpu);
-  log_info("addr: %d", addr);
+void AHX(cpu_t *cpu, addressing_modes_t mode) {
+  uint16_t addr = fetch_address(cpu, mode);
+  trace_cycle("addr: %d", addr);
   mem_write_byte(cpu, addr, (uint8_t)(get_upper_byte(addr) + 1) & (cpu->x & cpu->ac));
 }
 
 private
-void ANC(cpu_t *cpu) {
-  cpu->ac &= fetch_operand(cpu);
+void ANC(cpu_t *cpu, addressing_modes_t mode) {
+  cpu->ac &= fetch_operand(cpu, mode);
   cpu->s.bits.carry = check_if_bit7_set(cpu->ac);
   set_zero_negative(cpu, cpu->ac);
 }
 
 private
-void AND(cpu_t *cpu) {
-  cpu->ac &= fetch_operand(cpu);
+void AND(cpu_t *cpu, addressing_modes_t mode) {
+  cpu->ac &= fetch_operand(cpu, mode);
   set_zero_negative(cpu, cpu->ac);
 }
 
 private
-void ARR(cpu_t *cpu) {
-  cpu->ac &= fetch_operand(cpu);
+void ARR(cpu_t *cpu, addressing_modes_t mode) {
+  cpu->ac &= fetch_operand(cpu, mode);
   uint8_t carry_byte = (uint8_t)(cpu->s.bits.carry << 7);
 
   cpu->s.bits.carry = check_if_bit7_set(cpu->ac);
@@ -404,23 +463,23 @@ uint8_t ASL(cpu_t *cpu, uint8_t old_val) {
 }
 
 private
-void ASLa(cpu_t *cpu) {
-  fetch_operand(cpu);
+void ASLa(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);
   cpu->ac = ASL(cpu, cpu->ac);
 }
 
 private
-void ASLm(cpu_t *cpu) {
-  uint16_t addr = fetch_address(cpu);
-  uint8_t val = fetch_operand(cpu, addr);
+void ASLm(cpu_t *cpu, addressing_modes_t mode) {
+  uint16_t addr = fetch_address(cpu, mode);
+  uint8_t val = fetch_operand(cpu, mode, addr);
 
-  mem_write_byte(cpu, addr, val);  // dummy write
+  dummy_write_byte(cpu, addr, val);
   mem_write_byte(cpu, addr, ASL(cpu, val));
 }
 
 private
-void AXS(cpu_t *cpu) {
-  uint8_t val = fetch_operand(cpu);
+void AXS(cpu_t *cpu, addressing_modes_t mode) {
+  uint8_t val = fetch_operand(cpu, mode);
   cpu->x &= cpu->ac;
 
   cpu->s.bits.carry = cpu->x >= val;
@@ -430,8 +489,8 @@ void AXS(cpu_t *cpu) {
 }
 
 private
-void BIT(cpu_t *cpu) {
-  uint8_t val = fetch_operand(cpu);
+void BIT(cpu_t *cpu, addressing_modes_t mode) {
+  uint8_t val = fetch_operand(cpu, mode);
 
   cpu->s.bits.zero = (cpu->ac & val) == 0;
   cpu->s.bits.overflow = check_if_bit6_set(val);
@@ -439,51 +498,49 @@ void BIT(cpu_t *cpu) {
 }
 
 private
-void BRA(cpu_t *cpu, bool branch) {
-  int8_t signed_addr = fetch_operand(cpu);
+void BRA(cpu_t *cpu, addressing_modes_t mode, bool branch) {
+  int8_t signed_addr = fetch_operand(cpu, mode);
 
   if (branch) {
     uint16_t old_pc = cpu->pc;
     uint16_t new_pc = (uint16_t)(old_pc + signed_addr);
 
+    dummy_read_byte(cpu, old_pc);
     if (check_page_crossed(old_pc, signed_addr)) {
-      mem_read_byte(cpu);
-      uint16_t dummy_addr = clear_lower_byte(old_pc) | get_lower_byte(new_pc);
-      mem_read_byte(cpu, dummy_addr);
-    } else {
-      mem_read_byte(cpu);
+      stats_count(cpu, page_crossings);
+      dummy_read_byte(cpu, clear_lower_byte(old_pc) | get_lower_byte(new_pc));
     }
     cpu->pc = new_pc;
   }
 }
 
 private
-void BCC(cpu_t *cpu) { BRA(cpu, !cpu->s.bits.carry); }
+void BCC(cpu_t *cpu, addressing_modes_t mode) { BRA(cpu, mode, !cpu->s.bits.carry); }
 
 private
-void BCS(cpu_t *cpu) { BRA(cpu, cpu->s.bits.carry); }
+void BCS(cpu_t *cpu, addressing_modes_t mode) { BRA(cpu, mode, cpu->s.bits.carry); }
 
 private
-void BEQ(cpu_t *cpu) { BRA(cpu, cpu->s.bits.zero); }
+void BEQ(cpu_t *cpu, addressing_modes_t mode) { BRA(cpu, mode, cpu->s.bits.zero); }
 
 private
-void BMI(cpu_t *cpu) { BRA(cpu, cpu->s.bits.negative); }
+void BMI(cpu_t *cpu, addressing_modes_t mode) { BRA(cpu, mode, cpu->s.bits.negative); }
 
 private
-void BNE(cpu_t *cpu) { BRA(cpu, !cpu->s.bits.zero); }
+void BNE(cpu_t *cpu, addressing_modes_t mode) { BRA(cpu, mode, !cpu->s.bits.zero); }
 
 private
-void BPL(cpu_t *cpu) { BRA(cpu, !cpu->s.bits.negative); }
+void BPL(cpu_t *cpu, addressing_modes_t mode) { BRA(cpu, mode, !cpu->s.bits.negative); }
 
 private
-void BVC(cpu_t *cpu) { BRA(cpu, !cpu->s.bits.overflow); }
+void BVC(cpu_t *cpu, addressing_modes_t mode) { BRA(cpu, mode, !cpu->s.bits.overflow); }
 
 private
-void BVS(cpu_t *cpu) { BRA(cpu, cpu->s.bits.overflow); }
+void BVS(cpu_t *cpu, addressing_modes_t mode) { BRA(cpu, mode, cpu->s.bits.overflow); }
 
 private
-void BRK(cpu_t *cpu) {
-  fetch_operand(cpu);  // dummy read
+void BRK(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);  // dummy read
   push_word(cpu, cpu->pc + 1);
   push_byte(cpu, cpu->s.val | B);
   cpu->s.bits.interrupt_disable = true;
@@ -492,32 +549,32 @@ void BRK(cpu_t *cpu) {
 }
 
 private
-void CLC(cpu_t *cpu) {
-  fetch_operand(cpu);
+void CLC(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);
   cpu->s.bits.carry = false;
 }
 
 private
-void CLD(cpu_t *cpu) {
-  fetch_operand(cpu);
+void CLD(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);
   cpu->s.bits.decimal = false;
 }
 
 private
-void CLI(cpu_t *cpu) {
-  fetch_operand(cpu);
+void CLI(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);
   cpu->s.bits.interrupt_disable = false;
 }
 
 private
-void CLV(cpu_t *cpu) {
-  fetch_operand(cpu);
+void CLV(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);
   cpu->s.bits.overflow = false;
 }
 
 private
-void CMP(cpu_t *cpu, uint8_t reg) {
-  uint8_t val = fetch_operand(cpu);
+void CMP(cpu_t *cpu, addressing_modes_t mode, uint8_t reg) {
+  uint8_t val = fetch_operand(cpu, mode);
   uint8_t res = reg - val;
 
   cpu->s.bits.carry = reg >= val;
@@ -526,20 +583,20 @@ void CMP(cpu_t *cpu, uint8_t reg) {
 }
 
 private
-void CPA(cpu_t *cpu) { CMP(cpu, cpu->ac); }
+void CPA(cpu_t *cpu, addressing_modes_t mode) { CMP(cpu, mode, cpu->ac); }
 
 private
-void CPX(cpu_t *cpu) { CMP(cpu, cpu->x); }
+void CPX(cpu_t *cpu, addressing_modes_t mode) { CMP(cpu, mode, cpu->x); }
 
 private
-void CPY(cpu_t *cpu) { CMP(cpu, cpu->y); }
+void CPY(cpu_t *cpu, addressing_modes_t mode) { CMP(cpu, mode, cpu->y); }
 
 private
-void DCP(cpu_t *cpu) {
-  uint16_t addr = fetch_address(cpu);
-  uint8_t val = fetch_operand(cpu, addr);
+void DCP(cpu_t *cpu, addressing_modes_t mode) {
+  uint16_t addr = fetch_address(cpu, mode);
+  uint8_t val = fetch_operand(cpu, mode, addr);
 
-  mem_write_byte(cpu, addr, val--);
+  dummy_write_byte(cpu, addr, val--);
   uint8_t diff = cpu->ac - val;
 
   cpu->s.bits.carry = cpu->ac >= val;
@@ -549,72 +606,72 @@ void DCP(cpu_t *cpu) {
 }
 
 private
-void DEC(cpu_t *cpu) {
-  uint16_t addr = fetch_address(cpu);
-  uint8_t val = fetch_operand(cpu, addr);
+void DEC(cpu_t *cpu, addressing_modes_t mode) {
+  uint16_t addr = fetch_address(cpu, mode);
+  uint8_t val = fetch_operand(cpu, mode, addr);
 
-  mem_write_byte(cpu, addr, val);
+  dummy_write_byte(cpu, addr, val);
   mem_write_byte(cpu, addr, --val);
 
   set_zero_negative(cpu, val);
 }
 
 private
-void DEX(cpu_t *cpu) {
-  fetch_operand(cpu);
+void DEX(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);
   set_zero_negative(cpu, --cpu->x);
 }
 
 private
-void DEY(cpu_t *cpu) {
-  fetch_operand(cpu);
+void DEY(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);
   set_zero_negative(cpu, --cpu->y);
 }
 
 private
-void EOR(cpu_t *cpu) {
-  cpu->ac ^= fetch_operand(cpu);
+void EOR(cpu_t *cpu, addressing_modes_t mode) {
+  cpu->ac ^= fetch_operand(cpu, mode);
   set_zero_negative(cpu, cpu->ac);
 }
 
 private
-void INX(cpu_t *cpu) {
-  fetch_operand(cpu);
+void INX(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);
   set_zero_negative(cpu, ++cpu->x);
 }
 
 private
-void INC(cpu_t *cpu) {
-  uint16_t addr = fetch_address(cpu);
-  uint8_t val = fetch_operand(cpu, addr);
+void INC(cpu_t *cpu, addressing_modes_t mode) {
+  uint16_t addr = fetch_address(cpu, mode);
+  uint8_t val = fetch_operand(cpu, mode, addr);
 
-  mem_write_byte(cpu, addr, val);
+  dummy_write_byte(cpu, addr, val);
   mem_write_byte(cpu, addr, ++val);
 
   set_zero_negative(cpu, val);
 }
 
 private
-void INY(cpu_t *cpu) {
-  fetch_operand(cpu);
+void INY(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);
   set_zero_negative(cpu, ++cpu->y);
 }
 
 private
-void ISC(cpu_t *cpu) {
-  uint16_t addr = fetch_address(cpu);
-  uint8_t val = fetch_operand(cpu, addr);
+void ISC(cpu_t *cpu, addressing_modes_t mode) {
+  uint16_t addr = fetch_address(cpu, mode);
+  uint8_t val = fetch_operand(cpu, mode, addr);
 
-  mem_write_byte(cpu, addr, val++);
+  dummy_write_byte(cpu, addr, val++);
   ADD(cpu, ~val);
   mem_write_byte(cpu, addr, val);
 }
 
 private
-void JMP(cpu_t *cpu) { cpu->pc = fetch_address(cpu); }
+void JMP(cpu_t *cpu, addressing_modes_t mode) { cpu->pc = fetch_address(cpu, mode); }
 
 private
-void JSR(cpu_t *cpu) {
+void JSR(cpu_t *cpu, [[maybe_unused]] addressing_modes_t mode) {
   uint8_t lo = mem_read_byte(cpu);
   peek_byte(cpu);
   push_word(cpu, cpu->pc);
@@ -622,31 +679,31 @@ void JSR(cpu_t *cpu) {
 }
 
 private
-void LAS(cpu_t *cpu) {
-  cpu->ac = cpu->x = cpu->sp = fetch_operand(cpu) & cpu->sp;
+void LAS(cpu_t *cpu, addressing_modes_t mode) {
+  cpu->ac = cpu->x = cpu->sp = fetch_operand(cpu, mode) & cpu->sp;
   set_zero_negative(cpu, cpu->ac);
 }
 
 private
-void LAX(cpu_t *cpu) {
-  cpu->ac = cpu->x = fetch_operand(cpu);
+void LAX(cpu_t *cpu, addressing_modes_t mode) {
+  cpu->ac = cpu->x = fetch_operand(cpu, mode);
   set_zero_negative(cpu, cpu->ac);
 }
 
 private
-void LOD(cpu_t *cpu, uint8_t *reg) {
-  *reg = fetch_operand(cpu);
+void LOD(cpu_t *cpu, addressing_modes_t mode, uint8_t *reg) {
+  *reg = fetch_operand(cpu, mode);
   set_zero_negative(cpu, *reg);
 }
 
 private
-void LDA(cpu_t *cpu) { LOD(cpu, &cpu->ac); }
+void LDA(cpu_t *cpu, addressing_modes_t mode) { LOD(cpu, mode, &cpu->ac); }
 
 private
-void LDX(cpu_t *cpu) { LOD(cpu, &cpu->x); }
+void LDX(cpu_t *cpu, addressing_modes_t mode) { LOD(cpu, mode, &cpu->x); }
 
 private
-void LDY(cpu_t *cpu) { LOD(cpu, &cpu->y); }
+void LDY(cpu_t *cpu, addressing_modes_t mode) { LOD(cpu, mode, &cpu->y); }
 
 private
 uint8_t LSR(cpu_t *cpu, uint8_t val) {
@@ -657,77 +714,77 @@ uint8_t LSR(cpu_t *cpu, uint8_t val) {
 }
 
 private
-void ALR(cpu_t *cpu) {
-  cpu->ac &= fetch_operand(cpu);
+void ALR(cpu_t *cpu, addressing_modes_t mode) {
+  cpu->ac &= fetch_operand(cpu, mode);
   cpu->ac = LSR(cpu, cpu->ac);
 }
 
 private
-void LSRa(cpu_t *cpu) {
-  fetch_operand(cpu);
+void LSRa(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);
   cpu->ac = LSR(cpu, cpu->ac);
 }
 
 private
-void LSRm(cpu_t *cpu) {
-  uint16_t addr = fetch_address(cpu);
-  uint8_t val = fetch_operand(cpu, addr);
+void LSRm(cpu_t *cpu, addressing_modes_t mode) {
+  uint16_t addr = fetch_address(cpu, mode);
+  uint8_t val = fetch_operand(cpu, mode, addr);
   uint8_t shifted_val = LSR(cpu, val);
 
-  mem_write_byte(cpu, addr, val);  // dummy write
+  dummy_write_byte(cpu, addr, val);
   mem_write_byte(cpu, addr, shifted_val);
 }
 
 private
-void LXA(cpu_t *cpu) {
-  uint8_t val = fetch_operand(cpu);
+void LXA(cpu_t *cpu, addressing_modes_t mode) {
+  uint8_t val = fetch_operand(cpu, mode);
   cpu->ac = cpu->x = (cpu->ac | LXA_XAA_MAGIC) & val;
   set_zero_negative(cpu, cpu->ac);
 }
 
 private
-void NOP(cpu_t *cpu) { fetch_operand(cpu); }
+void NOP(cpu_t *cpu, addressing_modes_t mode) { fetch_operand(cpu, mode); }
 
 private
-void ORA(cpu_t *cpu) {
-  cpu->ac |= fetch_operand(cpu);
+void ORA(cpu_t *cpu, addressing_modes_t mode) {
+  cpu->ac |= fetch_operand(cpu, mode);
   set_zero_negative(cpu, cpu->ac);
 }
 
 private
-void PHA(cpu_t *cpu) {
-  fetch_operand(cpu);
+void PHA(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);
   push_byte(cpu, cpu->ac);
 }
 
 private
-void PHP(cpu_t *cpu) {
-  fetch_operand(cpu);
+void PHP(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);
   push_byte(cpu, cpu->s.val | B);
 }
 
 private
-void PLA(cpu_t *cpu) {
-  fetch_operand(cpu);
+void PLA(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);
   peek_byte(cpu);
   cpu->ac = pop_byte(cpu);
   set_zero_negative(cpu, cpu->ac);
 }
 
 private
-void PLP(cpu_t *cpu) {
-  fetch_operand(cpu);
+void PLP(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);
   peek_byte(cpu);
   cpu->s.val &= UNUSED | B;
   cpu->s.val |= pop_byte(cpu) & ~(UNUSED | B);
 }
 
 private
-void RLA(cpu_t *cpu) {
-  uint16_t addr = fetch_address(cpu);
-  uint8_t val = fetch_operand(cpu, addr);
+void RLA(cpu_t *cpu, addressing_modes_t mode) {
+  uint16_t addr = fetch_address(cpu, mode);
+  uint8_t val = fetch_operand(cpu, mode, addr);
 
-  mem_write_byte(cpu, addr, val);  // dummy write
+  dummy_write_byte(cpu, addr, val);
 
   bool old_carry = cpu->s.bits.carry;
   uint8_t shifted_val = (uint8_t)(val << 1) | old_carry;
@@ -749,19 +806,19 @@ uint8_t ROL(cpu_t *cpu, uint8_t old_val) {
 }
 
 private
-void ROLa(cpu_t *cpu) {
-  fetch_operand(cpu);
+void ROLa(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);
   uint8_t shifted_val = ROL(cpu, cpu->ac);
   cpu->ac = shifted_val;
 }
 
 private
-void ROLm(cpu_t *cpu) {
-  uint16_t addr = fetch_address(cpu);
-  uint8_t val = fetch_operand(cpu, addr);
+void ROLm(cpu_t *cpu, addressing_modes_t mode) {
+  uint16_t addr = fetch_address(cpu, mode);
+  uint8_t val = fetch_operand(cpu, mode, addr);
   uint8_t shifted_val = ROL(cpu, val);
 
-  mem_write_byte(cpu, addr, val);  // dummy write
+  dummy_write_byte(cpu, addr, val);
   mem_write_byte(cpu, addr, shifted_val);
 }
 
@@ -776,38 +833,38 @@ uint8_t ROR(cpu_t *cpu, uint8_t old_val) {
 }
 
 private
-void RORa(cpu_t *cpu) {
-  fetch_operand(cpu);
+void RORa(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);
   cpu->ac = ROR(cpu, cpu->ac);
 }
 
 private
-void RORm(cpu_t *cpu) {
-  uint16_t addr = fetch_address(cpu);
-  uint8_t val = fetch_operand(cpu, addr);
+void RORm(cpu_t *cpu, addressing_modes_t mode) {
+  uint16_t addr = fetch_address(cpu, mode);
+  uint8_t val = fetch_operand(cpu, mode, addr);
   uint8_t shifted_val = ROR(cpu, val);
 
-  mem_write_byte(cpu, addr, val);  // dummy write
+  dummy_write_byte(cpu, addr, val);
   mem_write_byte(cpu, addr, shifted_val);
 }
 
 private
-void RRA(cpu_t *cpu) {
-  uint16_t addr = fetch_address(cpu);
-  uint8_t val = fetch_operand(cpu, addr);
+void RRA(cpu_t *cpu, addressing_modes_t mode) {
+  uint16_t addr = fetch_address(cpu, mode);
+  uint8_t val = fetch_operand(cpu, mode, addr);
   uint8_t carry = (uint8_t)(cpu->s.bits.carry << 7);
 
   uint8_t shifted_val = (val >> 1) | carry;
   cpu->s.bits.carry = check_if_bit0_set(val);
   ADD(cpu, shifted_val);
 
-  mem_write_byte(cpu, addr, val);
+  dummy_write_byte(cpu, addr, val);
   mem_write_byte(cpu, addr, shifted_val);
 }
 
 private
-void RTI(cpu_t *cpu) {
-  fetch_operand(cpu);
+void RTI(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);
   peek_byte(cpu);
 
   cpu->s.val &= UNUSED | B;
@@ -816,65 +873,65 @@ void RTI(cpu_t *cpu) {
 }
 
 private
-void RTS(cpu_t *cpu) {
-  fetch_operand(cpu);
+void RTS(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);
   peek_byte(cpu);
   uint16_t addr = pop_word(cpu);
-  mem_read_byte(cpu, addr);
+  dummy_read_byte(cpu, addr);
   cpu->pc = addr + 1;
 }
 
 private
-void SAX(cpu_t *cpu) { mem_write_byte(cpu, fetch_address(cpu), cpu->ac & cpu->x); }
+void SAX(cpu_t *cpu, addressing_modes_t mode) { mem_write_byte(cpu, fetch_address(cpu, mode), cpu->ac & cpu->x); }
 
 private
-void SBC(cpu_t *cpu) { ADD(cpu, ~fetch_operand(cpu)); }
+void SBC(cpu_t *cpu, addressing_modes_t mode) { ADD(cpu, ~fetch_operand(cpu, mode)); }
 
 private
-void SEC(cpu_t *cpu) {
-  fetch_operand(cpu);
+void SEC(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);
   cpu->s.bits.carry = true;
 }
 
 private
-void SED(cpu_t *cpu) {
-  fetch_operand(cpu);
+void SED(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);
   cpu->s.bits.decimal = true;
 }
 
 private
-void SEI(cpu_t *cpu) {
-  fetch_operand(cpu);
+void SEI(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);
   cpu->s.bits.interrupt_disable = true;
 }
 
 // FIXME: later
 private
-void SHX(cpu_t *cpu) { return; }
+void SHX(cpu_t *cpu, [[maybe_unused]] addressing_modes_t mode) { return; }
 
 // FIXME: later
 private
-void SHY(cpu_t *cpu) { return; }
+void SHY(cpu_t *cpu, [[maybe_unused]] addressing_modes_t mode) { return; }
 
 private
-void SLO(cpu_t *cpu) {
-  uint16_t addr = fetch_address(cpu);
+void SLO(cpu_t *cpu, addressing_modes_t mode) {
+  uint16_t addr = fetch_address(cpu, mode);
 
-  uint8_t old_val = fetch_operand(cpu, addr);
+  uint8_t old_val = fetch_operand(cpu, mode, addr);
   uint8_t shifted_val = ASL(cpu, old_val);
 
   cpu->ac |= shifted_val;
 
-  mem_write_byte(cpu, addr, old_val);  // dummy write
+  dummy_write_byte(cpu, addr, old_val);
   mem_write_byte(cpu, addr, shifted_val);
   set_zero_negative(cpu, cpu->ac);
 }
 
 private
-void SRE(cpu_t *cpu) {
-  uint16_t addr = fetch_address(cpu);
-  uint8_t val = fetch_operand(cpu, addr);
-  mem_write_byte(cpu, addr, val);
+void SRE(cpu_t *cpu, addressing_modes_t mode) {
+  uint16_t addr = fetch_address(cpu, mode);
+  uint8_t val = fetch_operand(cpu, mode, addr);
+  dummy_write_byte(cpu, addr, val);
 
   cpu->s.bits.carry = get_0th_bit(val);
   uint8_t shifted_val = val >> 1;
@@ -886,62 +943,62 @@ void SRE(cpu_t *cpu) {
 
 // FIXME: Implement this opcode later
 private
-void STP(cpu_t *cpu) { fetch_operand(cpu); }
+void STP(cpu_t *cpu, addressing_modes_t mode) { fetch_operand(cpu, mode); }
 
 private
-void STR(cpu_t *cpu, uint8_t reg) { mem_write_byte(cpu, fetch_address(cpu), reg); }
+void STR(cpu_t *cpu, addressing_modes_t mode, uint8_t reg) { mem_write_byte(cpu, fetch_address(cpu, mode), reg); }
 
 private
-void STA(cpu_t *cpu) { STR(cpu, cpu->ac); }
+void STA(cpu_t *cpu, addressing_modes_t mode) { STR(cpu, mode, cpu->ac); }
 
 private
-void STX(cpu_t *cpu) { STR(cpu, cpu->x); }
+void STX(cpu_t *cpu, addressing_modes_t mode) { STR(cpu, mode, cpu->x); }
 
 private
-void STY(cpu_t *cpu) { STR(cpu, cpu->y); }
+void STY(cpu_t *cpu, addressing_modes_t mode) { STR(cpu, mode, cpu->y); }
 
 // FIXME: later
 private
-void TAS(cpu_t *cpu) { return; }
+void TAS(cpu_t *cpu, [[maybe_unused]] addressing_modes_t mode) { return; }
 
 private
-void TRA(cpu_t *cpu, uint8_t *reg_a, uint8_t reg_b) {
-  fetch_operand(cpu);
+void TRA(cpu_t *cpu, addressing_modes_t mode, uint8_t *reg_a, uint8_t reg_b) {
+  fetch_operand(cpu, mode);
   *reg_a = reg_b;
   set_zero_negative(cpu, *reg_a);
 }
 
 private
-void TAX(cpu_t *cpu) { TRA(cpu, &cpu->x, cpu->ac); }
+void TAX(cpu_t *cpu, addressing_modes_t mode) { TRA(cpu, mode, &cpu->x, cpu->ac); }
 
 private
-void TAY(cpu_t *cpu) { TRA(cpu, &cpu->y, cpu->ac); }
+void TAY(cpu_t *cpu, addressing_modes_t mode) { TRA(cpu, mode, &cpu->y, cpu->ac); }
 
 private
-void TSX(cpu_t *cpu) { TRA(cpu, &cpu->x, cpu->sp); }
+void TSX(cpu_t *cpu, addressing_modes_t mode) { TRA(cpu, mode, &cpu->x, cpu->sp); }
 
 private
-void TXA(cpu_t *cpu) { TRA(cpu, &cpu->ac, cpu->x); }
+void TXA(cpu_t *cpu, addressing_modes_t mode) { TRA(cpu, mode, &cpu->ac, cpu->x); }
 
 private
-void TYA(cpu_t *cpu) { TRA(cpu, &cpu->ac, cpu->y); }
+void TYA(cpu_t *cpu, addressing_modes_t mode) { TRA(cpu, mode, &cpu->ac, cpu->y); }
 
 private
-void TXS(cpu_t *cpu) {
-  fetch_operand(cpu);
+void TXS(cpu_t *cpu, addressing_modes_t mode) {
+  fetch_operand(cpu, mode);
   cpu->sp = cpu->x;
 }
 
 private
-void XAA(cpu_t *cpu) {
-  uint8_t val = fetch_operand(cpu);
+void XAA(cpu_t *cpu, addressing_modes_t mode) {
+  uint8_t val = fetch_operand(cpu, mode);
 
   cpu->ac = ((cpu->ac | LXA_XAA_MAGIC) & cpu->x & val);
   set_zero_negative(cpu, cpu->ac);
 }
 
 // clang-format off
-typedef void (*opcode_func_t)(cpu_t *cpu);
+typedef void (*opcode_func_t)(cpu_t *cpu, addressing_modes_t mode);
 static const opcode_func_t opcode_table[256] = {
   //+00 +01  +02  +03  +04  +05  +06   +07  +08  +09  +0A   +0B  +0C  +0D  +0E   +0F
   BRK,  ORA, STP, SLO, NOP, ORA, ASLm, SLO, PHP, ORA, ASLa, ANC, NOP, ORA, ASLm, SLO, // 00
@@ -982,9 +1039,8 @@ static const char *opcode_table_string[256] = {
 };
 // clang-format on
 
-cpu_t cpu_power_on(void) {
-  log_info("CPU powered on");
-  return (cpu_t){
+void cpu_power_on(cpu_t *cpu) {
+  *cpu = (cpu_t){
       .pc = RESET_VECTOR,
       .sp = 0xFD,
       .ac = 0,
@@ -992,8 +1048,23 @@ cpu_t cpu_power_on(void) {
       .y = 0,
       .s.val = UNUSED | INTERRUPT_DISABLE,
       .cycles = 0,
+      .deadline = 0,
+      .nmi_pending = false,
+      .irq_lines = 0,
       .mem = {},
   };
+
+  bus_init(&cpu->bus);
+#ifdef CPU_TESTS
+  bus_map_read_memory(&cpu->bus, 0x0000, 0xFFFF, cpu->mem, INTERNAL_RAM_SIZE);
+  bus_map_write_memory(&cpu->bus, 0x0000, 0xFFFF, cpu->mem, INTERNAL_RAM_SIZE);
+#else
+  // the 2KiB of internal RAM is mirrored four times over $0000-$1FFF
+  bus_map_read_memory(&cpu->bus, 0x0000, 0x1FFF, cpu->mem, INTERNAL_RAM_SIZE);
+  bus_map_write_memory(&cpu->bus, 0x0000, 0x1FFF, cpu->mem, INTERNAL_RAM_SIZE);
+#endif
+
+  trace_instruction("CPU powered on");
 }
 
 void cpu_reset(cpu_t *cpu) {
@@ -1001,14 +1072,136 @@ void cpu_reset(cpu_t *cpu) {
   cpu->sp -= 3;
   cpu->s.bits.interrupt_disable = true;
   cpu->cycles = 0;
-  log_info("CPU reset successful");
+  trace_instruction("CPU reset successful");
+}
+
+const char *cpu_opcode_name(uint8_t op) { return opcode_table_string[op]; }
+
+addressing_modes_t cpu_addressing_mode(uint8_t op) { return addr_mode_table[op]; }
+
+const char *cpu_addressing_mode_name(addressing_modes_t mode) {
+  return addressing_modes_string[mode];
+}
+
+// Called by every dispatcher once an instruction has executed
+private
+void instruction_done(cpu_t *cpu, uint8_t op) {
+  stats_count(cpu, opcodes[op]);
+  trace_instruction("ADDRESSING:%s INST:%s PC:%d AC:%d X:%d Y:%d S:%d SP:%d CYC:%ld",
+                    addressing_modes_string[addr_mode_table[op]], opcode_table_string[op], cpu->pc,
+                    cpu->ac, cpu->x, cpu->y, cpu->s.val, cpu->sp, cpu->cycles);
+}
+
+// clang-format off
+#define OPCODE_ROW(hi)                                                                        \
+  OPCODE(hi##0) OPCODE(hi##1) OPCODE(hi##2) OPCODE(hi##3) OPCODE(hi##4) OPCODE(hi##5)       \
+  OPCODE(hi##6) OPCODE(hi##7) OPCODE(hi##8) OPCODE(hi##9) OPCODE(hi##A) OPCODE(hi##B)       \
+  OPCODE(hi##C) OPCODE(hi##D) OPCODE(hi##E) OPCODE(hi##F)
+
+#define ALL_OPCODES                                                                           \
+  OPCODE_ROW(0x0) OPCODE_ROW(0x1) OPCODE_ROW(0x2) OPCODE_ROW(0x3) OPCODE_ROW(0x4)           \
+  OPCODE_ROW(0x5) OPCODE_ROW(0x6) OPCODE_ROW(0x7) OPCODE_ROW(0x8) OPCODE_ROW(0x9)           \
+  OPCODE_ROW(0xA) OPCODE_ROW(0xB) OPCODE_ROW(0xC) OPCODE_ROW(0xD) OPCODE_ROW(0xE)           \
+  OPCODE_ROW(0xF)
+// clang-format on
+
+// One specialized function per opcode. Indexing the constant tables with a constant folds the
+// handler into a direct call and the addressing mode into a constant argument, flatten then
+// inlines the handler so that the switch in fetch_address() and is_direct_value_mode() disappear.
+#define OPCODE(op)                                        \
+  [[gnu::flatten]] static void execute_##op(cpu_t *cpu) { \
+    opcode_table[op](cpu, addr_mode_table[op]);           \
+  }
+ALL_OPCODES
+#undef OPCODE
+
+typedef void (*specialized_opcode_func_t)(cpu_t *cpu);
+
+#define OPCODE(op) execute_##op,
+static const specialized_opcode_func_t specialized_opcode_table[256] = {ALL_OPCODES};
+#undef OPCODE
+
+// NMI and IRQ share the BRK sequence, except that the opcode fetch is replaced by a dummy read
+// and B is pushed clear
+private
+void service_interrupt(cpu_t *cpu, uint16_t vector) {
+  dummy_read_byte(cpu, cpu->pc);
+  dummy_read_byte(cpu, cpu->pc);
+  push_word(cpu, cpu->pc);
+  push_byte(cpu, (uint8_t)((cpu->s.val & ~B) | UNUSED));
+  cpu->s.bits.interrupt_disable = true;
+
+  cpu->pc = mem_read_word(cpu, vector);
+}
+
+// Interrupts are polled at instruction boundaries, NMI wins over IRQ
+private
+void poll_interrupts(cpu_t *cpu) {
+  if (cpu->nmi_pending) {
+    cpu->nmi_pending = false;
+    stats_count(cpu, nmis);
+    service_interrupt(cpu, NMI_VECTOR);
+  } else if (cpu->irq_lines && !cpu->s.bits.interrupt_disable) {
+    stats_count(cpu, irqs);
+    service_interrupt(cpu, IRQ_VECTOR);
+  }
 }
 
 void cpu_step(cpu_t *cpu) {
+  poll_interrupts(cpu);
+
   uint8_t op = mem_read_byte(cpu);
-  cpu->current_addr_mode = addr_mode_table[op];
-  opcode_table[op](cpu);
-  log_info("ADDRESSING:%s INST:%s PC:%d AC:%d X:%d Y:%d S:%d SP:%d CYC:%ld",
-           addressing_modes_string[cpu->current_addr_mode], opcode_table_string[op], cpu->pc,
-           cpu->ac, cpu->x, cpu->y, cpu->s.val, cpu->sp, cpu->cycles);
+  specialized_opcode_table[op](cpu);
+  instruction_done(cpu, op);
 }
+
+// The table driven path, the addressing mode is looked up and decoded at runtime. Kept to cross
+// check the specialized handlers against.
+void cpu_step_generic(cpu_t *cpu) {
+  poll_interrupts(cpu);
+
+  uint8_t op = mem_read_byte(cpu);
+  opcode_table[op](cpu, addr_mode_table[op]);
+  instruction_done(cpu, op);
+}
+
+#if defined(CPU_DISPATCH_THREADED) && defined(__GNUC__)
+// Threaded dispatch using the labels as values extension of GCC and Clang: every opcode gets its
+// own label, and every label ends in its own indirect jump to the next opcode. Each jump is then
+// predicted separately instead of all opcodes sharing the one call in cpu_step().
+void cpu_run_until(cpu_t *cpu, uint64_t target_cycle) {
+  cpu->deadline = target_cycle;
+
+#define OPCODE(op) &&op_##op,
+  static void *const dispatch_table[256] = {ALL_OPCODES};
+#undef OPCODE
+
+#define OPCODE(op)                    \
+  op_##op : execute_##op(cpu);        \
+  instruction_done(cpu, op);          \
+  if (cpu->cycles >= cpu->deadline) { \
+    return;                           \
+  }                                   \
+  poll_interrupts(cpu);               \
+  goto *dispatch_table[mem_read_byte(cpu)];
+
+  if (cpu->cycles >= cpu->deadline) {
+    return;
+  }
+  poll_interrupts(cpu);
+  goto *dispatch_table[mem_read_byte(cpu)];
+
+  ALL_OPCODES
+#undef OPCODE
+}
+#else
+void cpu_run_until(cpu_t *cpu, uint64_t target_cycle) {
+  cpu->deadline = target_cycle;
+
+  while (cpu->cycles < cpu->deadline) {
+    cpu_step(cpu);
+  }
+}
+#endif
+
+void cpu_run(cpu_t *cpu, uint64_t cycles) { cpu_run_until(cpu, cpu->cycles + cycles); }
@@ -2,6 +2,13 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include "bus.h"
+
+#ifdef BUS_TRACE
+#include "bus_trace.h"
+#endif
 
 #ifdef CPU_TESTS
 //  The https://github.com/SingleStepTests/65x02 tests expect full 64KiB memory mapped to the CPU
@@ -10,6 +17,27 @@ constexpr uint32_t INTERNAL_RAM_SIZE = 64 * 1024;
 constexpr uint32_t INTERNAL_RAM_SIZE = 2 * 1024;
 #endif
 
+#ifdef CPU_BUS_LOG
+// Enough for a few instructions, the longest one takes 7 cycles and an interrupt 7 more
+constexpr size_t CPU_BUS_LOG_CAPACITY = 32;
+
+typedef struct {
+  uint16_t addr;
+  uint8_t val;
+  uint8_t kind;  // bus_access_t
+} cpu_bus_access_t;
+
+// Every bus access since the last cpu_bus_log_clear(), in order, enabled at compile time with
+// -DCPU_BUS_LOG. Unlike BUS_TRACE it lives inside the CPU and keeps the first accesses rather than
+// the last ones, it is meant to be compared against expected accesses, e.g. those of a
+// SingleStepTests case, or against another CPU's log. Accesses past the capacity are counted but
+// not stored.
+typedef struct {
+  cpu_bus_access_t accesses[CPU_BUS_LOG_CAPACITY];
+  size_t count;
+} cpu_bus_log_t;
+#endif
+
 typedef enum {
   ADDRESSING_ABSOLUTE,
   ADDRESSING_ABSOLUTE_X,
@@ -30,6 +58,26 @@ typedef enum {
   ADDRESSING_ZERO_PAGE_Y
 } addressing_modes_t;
 
+#ifdef NES_STATS
+// Counters of the CPU hot paths, enabled at compile time with -DNES_STATS, without it they are
+// not even part of cpu_t
+typedef struct {
+  uint64_t opcodes[256];    // instructions executed, per opcode
+  uint64_t page_crossings;  // extra cycles of indexed reads and taken branches crossing a page
+  uint64_t dummy_reads;     // reads whose value is thrown away
+  uint64_t dummy_writes;    // writes of the unmodified value by read-modify-write instructions
+  uint64_t nmis;
+  uint64_t irqs;
+} cpu_stats_t;
+#endif
+
+// Devices that can pull the shared IRQ line low
+typedef enum {
+  IRQ_SOURCE_APU_FRAME_COUNTER = 1 << 0,
+  IRQ_SOURCE_DMC = 1 << 1,
+  IRQ_SOURCE_MAPPER = 1 << 2,
+} irq_source_t;
+
 typedef union {
   struct {
     bool carry : 1;
@@ -51,11 +99,61 @@ typedef struct {
   uint8_t x;
   uint8_t y;
   status_flag_t s;
-  size_t cycles;  // FIXME: what should be its data type?
+  uint64_t cycles;    // CPU cycles since power on, 64 bits never wrap in practice
+  uint64_t deadline;  // cpu_run_until() returns at the first instruction boundary at or past this
+  bool nmi_pending;   // NMI is edge triggered, it is latched until serviced
+  uint8_t irq_lines;  // irq_source_t bitmask, IRQ is level triggered and asserted while non zero
   uint8_t mem[INTERNAL_RAM_SIZE];
-  addressing_modes_t current_addr_mode;
+  bus_t bus;
+#ifdef BUS_TRACE
+  bus_trace_t *bus_trace;  // every bus access is recorded here when not null
+#endif
+#ifdef CPU_BUS_LOG
+  cpu_bus_log_t bus_log;
+#endif
+#ifdef NES_STATS
+  cpu_stats_t stats;
+#endif
 } cpu_t;
 
-cpu_t cpu_power_on(void);
+// The bus holds pointers into `mem`, so the CPU is powered on in place instead of being returned
+// by value
+void cpu_power_on(cpu_t *cpu);
 void cpu_reset(cpu_t *cpu);
 void cpu_step(cpu_t *cpu);
+void cpu_step_generic(cpu_t *cpu);
+// Executes whole instructions until the cycle counter reaches `target_cycle` (typically the next
+// PPU/APU/IRQ event), without returning to the caller in between. Build with
+// -DCPU_DISPATCH_THREADED to use the computed goto dispatcher.
+void cpu_run_until(cpu_t *cpu, uint64_t target_cycle);
+void cpu_run(cpu_t *cpu, uint64_t cycles);
+
+// Describe the instructions for tools that report per opcode, with the names used by the traces
+const char *cpu_opcode_name(uint8_t op);
+addressing_modes_t cpu_addressing_mode(uint8_t op);
+const char *cpu_addressing_mode_name(addressing_modes_t mode);
+
+#ifdef CPU_BUS_LOG
+static inline void cpu_bus_log_clear(cpu_t *cpu) { cpu->bus_log.count = 0; }
+
+// True if both logs saw the same accesses, including the number of accesses past the capacity
+static inline bool cpu_bus_log_equal(const cpu_bus_log_t *a, const cpu_bus_log_t *b) {
+  size_t stored = a->count < CPU_BUS_LOG_CAPACITY ? a->count : CPU_BUS_LOG_CAPACITY;
+  return a->count == b->count &&
+         memcmp(a->accesses, b->accesses, stored * sizeof(*a->accesses)) == 0;
+}
+#endif
+
+static inline void cpu_trigger_nmi(cpu_t *cpu) { cpu->nmi_pending = true; }
+
+static inline void cpu_set_irq(cpu_t *cpu, irq_source_t source, bool asserted) {
+  cpu->irq_lines = (uint8_t)(asserted ? cpu->irq_lines | source : cpu->irq_lines & ~source);
+}
+
+// Can be called from a bus handler while cpu_run_until() is executing, nes.c does so when a
+// register write schedules an event that is due before the current deadline
+static inline void cpu_lower_deadline(cpu_t *cpu, uint64_t deadline) {
+  if (deadline < cpu->deadline) {
+    cpu->deadline = deadline;
+  }
+}
@@ -0,0 +1,188 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#include "hash.h"
+
+#include <threads.h>
+
+#include "utils.h"
+
+static constexpr uint32_t CRC32_POLYNOMIAL = 0xEDB88320;
+
+// crc_tables[k][b] is the CRC of byte b followed by k zero bytes, which lets crc32_update() fold
+// in 8 bytes per step instead of one ("slicing-by-8")
+static uint32_t crc_tables[8][256];
+static once_flag crc_tables_once = ONCE_FLAG_INIT;
+
+private
+void init_crc_tables(void) {
+  for (uint32_t byte = 0; byte < 256; byte++) {
+    uint32_t crc = byte;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (CRC32_POLYNOMIAL & -(crc & 1));
+    }
+    crc_tables[0][byte] = crc;
+  }
+
+  for (uint32_t byte = 0; byte < 256; byte++) {
+    for (uint8_t k = 1; k < 8; k++) {
+      uint32_t prev = crc_tables[k - 1][byte];
+      crc_tables[k][byte] = (prev >> 8) ^ crc_tables[0][prev & 0xFF];
+    }
+  }
+}
+
+private
+uint32_t load_le32(const uint8_t *p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+private
+uint32_t load_be32(const uint8_t *p) {
+  return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | (uint32_t)p[3];
+}
+
+private
+void store_be32(uint8_t *p, uint32_t val) {
+  p[0] = (uint8_t)(val >> 24);
+  p[1] = (uint8_t)(val >> 16);
+  p[2] = (uint8_t)(val >> 8);
+  p[3] = (uint8_t)val;
+}
+
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t size) {
+  call_once(&crc_tables_once, init_crc_tables);
+  crc = ~crc;
+
+  for (; size >= 8; size -= 8, data += 8) {
+    uint32_t lo = load_le32(data) ^ crc;
+    uint32_t hi = load_le32(data + 4);
+    crc = crc_tables[7][lo & 0xFF] ^ crc_tables[6][(lo >> 8) & 0xFF] ^
+          crc_tables[5][(lo >> 16) & 0xFF] ^ crc_tables[4][lo >> 24] ^
+          crc_tables[3][hi & 0xFF] ^ crc_tables[2][(hi >> 8) & 0xFF] ^
+          crc_tables[1][(hi >> 16) & 0xFF] ^ crc_tables[0][hi >> 24];
+  }
+
+  for (; size > 0; size--, data++) {
+    crc = (crc >> 8) ^ crc_tables[0][(crc ^ *data) & 0xFF];
+  }
+
+  return ~crc;
+}
+
+private
+uint32_t rotate_left(uint32_t val, uint8_t bits) { return (val << bits) | (val >> (32 - bits)); }
+
+private
+void sha1_compress(uint32_t state[5], const uint8_t *block) {
+  uint32_t w[80];
+  for (uint8_t i = 0; i < 16; i++) {
+    w[i] = load_be32(block + 4 * i);
+  }
+  for (uint8_t i = 16; i < 80; i++) {
+    w[i] = rotate_left(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+  }
+
+  uint32_t a = state[0];
+  uint32_t b = state[1];
+  uint32_t c = state[2];
+  uint32_t d = state[3];
+  uint32_t e = state[4];
+
+  for (uint8_t i = 0; i < 80; i++) {
+    uint32_t f;
+    uint32_t k;
+    if (i < 20) {
+      f = (b & c) | (~b & d);
+      k = 0x5A827999;
+    } else if (i < 40) {
+      f = b ^ c ^ d;
+      k = 0x6ED9EBA1;
+    } else if (i < 60) {
+      f = (b & c) | (b & d) | (c & d);
+      k = 0x8F1BBCDC;
+    } else {
+      f = b ^ c ^ d;
+      k = 0xCA62C1D6;
+    }
+
+    uint32_t temp = rotate_left(a, 5) + f + e + k + w[i];
+    e = d;
+    d = c;
+    c = rotate_left(b, 30);
+    b = a;
+    a = temp;
+  }
+
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+}
+
+void sha1_init(sha1_t *sha1) {
+  *sha1 = (sha1_t){.state = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0}};
+}
+
+void sha1_update(sha1_t *sha1, const uint8_t *data, size_t size) {
+  sha1->length += size;
+
+  if (sha1->block_used > 0) {
+    size_t take = SHA1_BLOCK_SIZE - sha1->block_used;
+    take = take < size ? take : size;
+    memcpy(sha1->block + sha1->block_used, data, take);
+    sha1->block_used += take;
+    data += take;
+    size -= take;
+
+    if (sha1->block_used < SHA1_BLOCK_SIZE) {
+      return;
+    }
+    sha1_compress(sha1->state, sha1->block);
+    sha1->block_used = 0;
+  }
+
+  // whole blocks are hashed straight from `data`
+  for (; size >= SHA1_BLOCK_SIZE; size -= SHA1_BLOCK_SIZE, data += SHA1_BLOCK_SIZE) {
+    sha1_compress(sha1->state, data);
+  }
+
+  memcpy(sha1->block, data, size);
+  sha1->block_used = size;
+}
+
+void sha1_final(sha1_t *sha1, uint8_t digest[SHA1_DIGEST_SIZE]) {
+  uint64_t bits = sha1->length * 8;
+  uint8_t padding[SHA1_BLOCK_SIZE + 8] = {0x80};
+
+  // pad with 0x80 and zeros up to 8 bytes before the end of a block, which hold the length
+  size_t padding_size = (sha1->block_used < 56 ? 56 : 120) - sha1->block_used;
+  for (uint8_t i = 0; i < 8; i++) {
+    padding[padding_size + i] = (uint8_t)(bits >> (56 - 8 * i));
+  }
+  sha1_update(sha1, padding, padding_size + 8);
+
+  for (uint8_t i = 0; i < 5; i++) {
+    store_be32(digest + 4 * i, sha1->state[i]);
+  }
+}
+
+void sha1(const uint8_t *data, size_t size, uint8_t digest[SHA1_DIGEST_SIZE]) {
+  sha1_t context;
+  sha1_init(&context);
+  sha1_update(&context, data, size);
+  sha1_final(&context, digest);
+}
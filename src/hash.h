@@ -0,0 +1,38 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+static constexpr size_t SHA1_DIGEST_SIZE = 20;
+static constexpr size_t SHA1_BLOCK_SIZE = 64;
+
+typedef struct {
+  uint32_t state[5];
+  uint64_t length;  // bytes hashed so far
+  uint8_t block[SHA1_BLOCK_SIZE];
+  size_t block_used;
+} sha1_t;
+
+// CRC-32 as used by zip, gzip and the No-Intro/GoodNES databases. Start with a crc of 0 and pass
+// the result of one call into the next to hash data in pieces.
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t size);
+
+void sha1_init(sha1_t *sha1);
+void sha1_update(sha1_t *sha1, const uint8_t *data, size_t size);
+void sha1_final(sha1_t *sha1, uint8_t digest[SHA1_DIGEST_SIZE]);
+void sha1(const uint8_t *data, size_t size, uint8_t digest[SHA1_DIGEST_SIZE]);
@@ -0,0 +1,358 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#include "inflate.h"
+
+#include <threads.h>
+
+#include "utils.h"
+
+static constexpr uint8_t MAX_CODE_LENGTH = 15;
+static constexpr uint16_t LITERAL_LENGTH_CODES = 288;
+static constexpr uint16_t DISTANCE_CODES = 30;
+static constexpr uint16_t END_OF_BLOCK = 256;
+static constexpr uint8_t FAST_BITS = 10;
+static constexpr uint8_t SYMBOL_BITS = 9;
+
+static const uint16_t length_base[] = {3,  4,  5,  6,  7,  8,  9,  10,  11,  13,
+                                       15, 17, 19, 23, 27, 31, 35, 43,  51,  59,
+                                       67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t length_extra[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                       2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t distance_base[] = {1,    2,    3,    4,    5,    7,     9,     13,
+                                         17,   25,   33,   49,   65,   97,    129,   193,
+                                         257,  385,  513,  769,  1025, 1537,  2049,  3073,
+                                         4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t distance_extra[] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                         6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+// the order the code length code lengths of a dynamic block are stored in
+static const uint8_t code_length_order[] = {16, 17, 18, 0, 8,  7, 9,  6, 10, 5,
+                                            11, 4,  12, 3, 13, 2, 14, 1, 15};
+
+// A canonical Huffman code. Codes of up to FAST_BITS bits are decoded with one lookup in `fast`,
+// which holds (length << SYMBOL_BITS) | symbol for every possible FAST_BITS bit prefix, or 0 if
+// the code is longer. Those are decoded a bit at a time from `counts` and `symbols`.
+typedef struct {
+  uint16_t counts[MAX_CODE_LENGTH + 1];
+  uint16_t symbols[LITERAL_LENGTH_CODES];
+  uint16_t fast[1 << FAST_BITS];
+} huffman_t;
+
+typedef struct {
+  const uint8_t *in;
+  size_t in_size;
+  size_t in_pos;
+  uint64_t bits;  // read but not yet consumed bits, the next one in bit 0
+  uint8_t bit_count;
+
+  uint8_t *out;
+  size_t out_size;
+  size_t out_pos;
+} inflater_t;
+
+// Past the end of the input zeros are shifted in, reading them is caught by input_overrun()
+private
+void refill(inflater_t *inflater) {
+  while (inflater->bit_count <= 56) {
+    uint64_t byte = inflater->in_pos < inflater->in_size ? inflater->in[inflater->in_pos] : 0;
+    inflater->in_pos++;
+    inflater->bits |= byte << inflater->bit_count;
+    inflater->bit_count += 8;
+  }
+}
+
+private
+bool input_overrun(const inflater_t *inflater) {
+  return inflater->in_pos - inflater->bit_count / 8 > inflater->in_size;
+}
+
+private
+uint32_t get_bits(inflater_t *inflater, uint8_t count) {
+  if (inflater->bit_count < count) {
+    refill(inflater);
+  }
+
+  uint32_t val = (uint32_t)(inflater->bits & ((1ull << count) - 1));
+  inflater->bits >>= count;
+  inflater->bit_count -= count;
+  return val;
+}
+
+private
+uint16_t reverse_bits(uint16_t code, uint8_t length) {
+  uint16_t reversed = 0;
+  for (uint8_t i = 0; i < length; i++, code >>= 1) {
+    reversed = (uint16_t)((reversed << 1) | (code & 1));
+  }
+  return reversed;
+}
+
+// Incomplete codes are allowed, as DEFLATE uses them for distance codes with a single symbol
+[[nodiscard]] private
+bool build_huffman(huffman_t *huffman, const uint8_t *lengths, uint16_t symbol_count) {
+  memset(huffman->counts, 0, sizeof(huffman->counts));
+  memset(huffman->fast, 0, sizeof(huffman->fast));
+
+  for (uint16_t symbol = 0; symbol < symbol_count; symbol++) {
+    huffman->counts[lengths[symbol]]++;
+  }
+  huffman->counts[0] = 0;
+
+  // the first code of every length and where its symbols start in `symbols`
+  uint16_t next_code[MAX_CODE_LENGTH + 1];
+  uint16_t offsets[MAX_CODE_LENGTH + 1];
+  int32_t left = 1;
+  uint16_t code = 0;
+  offsets[1] = 0;
+  for (uint8_t length = 1; length <= MAX_CODE_LENGTH; length++) {
+    left = 2 * left - huffman->counts[length];
+    return_value_if(left < 0, false, "over-subscribed Huffman code");
+
+    code = (uint16_t)((code + huffman->counts[length - 1]) << 1);
+    next_code[length] = code;
+    if (length < MAX_CODE_LENGTH) {
+      offsets[length + 1] = offsets[length] + huffman->counts[length];
+    }
+  }
+
+  for (uint16_t symbol = 0; symbol < symbol_count; symbol++) {
+    uint8_t length = lengths[symbol];
+    if (length == 0) {
+      continue;
+    }
+
+    huffman->symbols[offsets[length]++] = symbol;
+    uint16_t reversed = reverse_bits(next_code[length]++, length);
+    if (length <= FAST_BITS) {
+      for (uint32_t i = reversed; i < (1u << FAST_BITS); i += 1u << length) {
+        huffman->fast[i] = (uint16_t)((length << SYMBOL_BITS) | symbol);
+      }
+    }
+  }
+
+  return true;
+}
+
+// Returns the next symbol, or -1 for a code that is not part of `huffman`
+private
+int32_t decode_symbol(inflater_t *inflater, const huffman_t *huffman) {
+  if (inflater->bit_count < MAX_CODE_LENGTH) {
+    refill(inflater);
+  }
+
+  uint16_t entry = huffman->fast[inflater->bits & ((1u << FAST_BITS) - 1)];
+  if (entry) {
+    uint8_t length = (uint8_t)(entry >> SYMBOL_BITS);
+    inflater->bits >>= length;
+    inflater->bit_count -= length;
+    return entry & ((1u << SYMBOL_BITS) - 1);
+  }
+
+  // codes are stored starting from their most significant bit
+  int32_t code = 0;
+  int32_t first = 0;
+  int32_t index = 0;
+  for (uint8_t length = 1; length <= MAX_CODE_LENGTH; length++) {
+    code |= (int32_t)((inflater->bits >> (length - 1)) & 1);
+    int32_t count = huffman->counts[length];
+    if (code - first < count) {
+      inflater->bits >>= length;
+      inflater->bit_count -= length;
+      return huffman->symbols[index + code - first];
+    }
+    index += count;
+    first = (first + count) << 1;
+    code <<= 1;
+  }
+
+  return -1;
+}
+
+[[nodiscard]] private
+bool inflate_stored(inflater_t *inflater) {
+  // the length is byte aligned, the bits left in the current byte are skipped
+  get_bits(inflater, inflater->bit_count % 8);
+  uint16_t length = (uint16_t)get_bits(inflater, 16);
+  uint16_t inverted = (uint16_t)get_bits(inflater, 16);
+  return_value_if((length ^ inverted) != 0xFFFF, false, "corrupt stored block length");
+  return_value_if(length > inflater->out_size - inflater->out_pos, false, "output overflow");
+
+  // empty the bit buffer first, then copy straight from the input
+  uint16_t copied = 0;
+  for (; copied < length && inflater->bit_count >= 8; copied++) {
+    inflater->out[inflater->out_pos++] = (uint8_t)get_bits(inflater, 8);
+  }
+
+  size_t remaining = length - copied;
+  size_t in_pos = inflater->in_pos - inflater->bit_count / 8;
+  return_value_if(in_pos > inflater->in_size || remaining > inflater->in_size - in_pos, false,
+                  "input overrun");
+  memcpy(inflater->out + inflater->out_pos, inflater->in + in_pos, remaining);
+  inflater->out_pos += remaining;
+  inflater->in_pos = in_pos + remaining;
+  inflater->bits = 0;
+  inflater->bit_count = 0;
+  return true;
+}
+
+[[nodiscard]] private
+bool inflate_codes(inflater_t *inflater, const huffman_t *literals, const huffman_t *distances) {
+  for (;;) {
+    int32_t symbol = decode_symbol(inflater, literals);
+    return_value_if(symbol < 0 || input_overrun(inflater), false, "corrupt literal/length code");
+
+    if (symbol < END_OF_BLOCK) {
+      return_value_if(inflater->out_pos == inflater->out_size, false, "output overflow");
+      inflater->out[inflater->out_pos++] = (uint8_t)symbol;
+      continue;
+    }
+    if (symbol == END_OF_BLOCK) {
+      return true;
+    }
+
+    symbol -= END_OF_BLOCK + 1;
+    return_value_if(symbol >= 29, false, "invalid length code %d", symbol);
+    size_t length = length_base[symbol] + get_bits(inflater, length_extra[symbol]);
+
+    symbol = decode_symbol(inflater, distances);
+    return_value_if(symbol < 0 || symbol >= DISTANCE_CODES, false, "corrupt distance code");
+    size_t distance = distance_base[symbol] + get_bits(inflater, distance_extra[symbol]);
+
+    return_value_if(distance > inflater->out_pos, false, "distance too far back");
+    return_value_if(length > inflater->out_size - inflater->out_pos, false, "output overflow");
+
+    // matches may overlap their own output, which repeats the last `distance` bytes
+    uint8_t *dst = inflater->out + inflater->out_pos;
+    const uint8_t *src = dst - distance;
+    if (distance >= length) {
+      memcpy(dst, src, length);
+    } else {
+      for (size_t i = 0; i < length; i++) {
+        dst[i] = src[i];
+      }
+    }
+    inflater->out_pos += length;
+  }
+}
+
+static huffman_t fixed_literals;
+static huffman_t fixed_distances;
+static bool fixed_built;
+static once_flag fixed_once = ONCE_FLAG_INIT;
+
+private
+void build_fixed_codes(void) {
+  uint8_t lengths[LITERAL_LENGTH_CODES];
+  memset(lengths, 8, 144);
+  memset(lengths + 144, 9, 256 - 144);
+  memset(lengths + 256, 7, 280 - 256);
+  memset(lengths + 280, 8, LITERAL_LENGTH_CODES - 280);
+  fixed_built = build_huffman(&fixed_literals, lengths, LITERAL_LENGTH_CODES);
+
+  memset(lengths, 5, DISTANCE_CODES);
+  fixed_built = fixed_built && build_huffman(&fixed_distances, lengths, DISTANCE_CODES);
+}
+
+[[nodiscard]] private
+bool inflate_fixed(inflater_t *inflater) {
+  call_once(&fixed_once, build_fixed_codes);
+  return_value_if(!fixed_built, false, "cannot build the fixed Huffman codes");
+  return inflate_codes(inflater, &fixed_literals, &fixed_distances);
+}
+
+[[nodiscard]] private
+bool inflate_dynamic(inflater_t *inflater) {
+  uint16_t literal_count = (uint16_t)get_bits(inflater, 5) + 257;
+  uint16_t distance_count = (uint16_t)get_bits(inflater, 5) + 1;
+  uint8_t code_length_count = (uint8_t)get_bits(inflater, 4) + 4;
+  return_value_if(literal_count > 286 || distance_count > DISTANCE_CODES, false,
+                  "too many codes in a dynamic block");
+
+  uint8_t lengths[LITERAL_LENGTH_CODES + DISTANCE_CODES] = {};
+  for (uint8_t i = 0; i < code_length_count; i++) {
+    lengths[code_length_order[i]] = (uint8_t)get_bits(inflater, 3);
+  }
+
+  huffman_t code_lengths;
+  return_value_if(!build_huffman(&code_lengths, lengths, 19), false, "corrupt code length code");
+
+  // the literal/length and distance code lengths form one sequence, repeats may cross over
+  memset(lengths, 0, sizeof(lengths));
+  for (uint16_t i = 0; i < literal_count + distance_count;) {
+    int32_t symbol = decode_symbol(inflater, &code_lengths);
+    return_value_if(symbol < 0 || input_overrun(inflater), false, "corrupt code lengths");
+
+    if (symbol < 16) {
+      lengths[i++] = (uint8_t)symbol;
+      continue;
+    }
+
+    uint8_t repeated = 0;
+    uint32_t repeat;
+    if (symbol == 16) {
+      return_value_if(i == 0, false, "repeat without a previous code length");
+      repeated = lengths[i - 1];
+      repeat = 3 + get_bits(inflater, 2);
+    } else if (symbol == 17) {
+      repeat = 3 + get_bits(inflater, 3);
+    } else {
+      repeat = 11 + get_bits(inflater, 7);
+    }
+
+    return_value_if(i + repeat > literal_count + distance_count, false, "too many code lengths");
+    memset(lengths + i, repeated, repeat);
+    i += (uint16_t)repeat;
+  }
+  return_value_if(lengths[END_OF_BLOCK] == 0, false, "dynamic block without an end code");
+
+  huffman_t literals;
+  huffman_t distances;
+  return_value_if(!build_huffman(&literals, lengths, literal_count), false,
+                  "corrupt literal/length code");
+  return_value_if(!build_huffman(&distances, lengths + literal_count, distance_count), false,
+                  "corrupt distance code");
+  return inflate_codes(inflater, &literals, &distances);
+}
+
+bool inflate(const uint8_t *in, size_t in_size, uint8_t *out, size_t out_size,
+             size_t *out_written) {
+  inflater_t inflater = {.in = in, .in_size = in_size, .out = out, .out_size = out_size};
+  bool last;
+
+  do {
+    last = get_bits(&inflater, 1);
+    uint8_t type = (uint8_t)get_bits(&inflater, 2);
+    bool ok = false;
+
+    switch (type) {
+      case 0:
+        ok = inflate_stored(&inflater);
+        break;
+      case 1:
+        ok = inflate_fixed(&inflater);
+        break;
+      case 2:
+        ok = inflate_dynamic(&inflater);
+        break;
+      default:
+        log_error("invalid block type");
+    }
+
+    return_value_if(!ok || input_overrun(&inflater), false, "corrupt DEFLATE stream");
+  } while (!last);
+
+  *out_written = inflater.out_pos;
+  return true;
+}
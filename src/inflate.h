@@ -0,0 +1,25 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Decompresses the raw DEFLATE stream (RFC 1951) `in` into `out`, which has to be large enough for
+// all of it: containers like gzip and zip store the uncompressed size, so the output never has to
+// grow. `out_written` is set to the number of bytes written.
+[[nodiscard]] bool inflate(const uint8_t *in, size_t in_size, uint8_t *out, size_t out_size,
+                           size_t *out_written);
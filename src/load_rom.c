@@ -16,16 +16,48 @@ You should have received a copy of the GNU General Public License along with nem
 #include "load_rom.h"
 
 #include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 
+#include "hash.h"
+#include "inflate.h"
+#include "rom_db.h"
 #include "utils.h"
 
-// TODO: support loading from compressed files
 static constexpr uint8_t HEADER_SIZE = 16;
 static constexpr uint8_t INES2_EXPONENTIATION_MODE = 0x0F;
 static constexpr uint16_t CHR_ROM_UNIT_SIZE = 8 * 1024;
 static constexpr uint16_t INES_PRG_RAM_UNIT_SIZE = 8 * 1024;
 static constexpr uint16_t PRG_ROM_UNIT_SIZE = 16 * 1024;
+static constexpr uint16_t TRAINER_AREA_SIZE = 512;
+
+static constexpr uint8_t GZIP_HEADER_SIZE = 10;
+static constexpr uint8_t GZIP_TRAILER_SIZE = 8;
+static constexpr uint8_t GZIP_FLAG_HEADER_CRC = 0x02;
+static constexpr uint8_t GZIP_FLAG_EXTRA = 0x04;
+static constexpr uint8_t GZIP_FLAG_NAME = 0x08;
+static constexpr uint8_t GZIP_FLAG_COMMENT = 0x10;
+static constexpr uint32_t ZIP_LOCAL_HEADER_SIGNATURE = 0x04034B50;
+static constexpr uint32_t ZIP_CENTRAL_HEADER_SIGNATURE = 0x02014B50;
+static constexpr uint32_t ZIP_END_SIGNATURE = 0x06054B50;
+static constexpr uint8_t ZIP_LOCAL_HEADER_SIZE = 30;
+static constexpr uint8_t ZIP_CENTRAL_HEADER_SIZE = 46;
+static constexpr uint8_t ZIP_END_SIZE = 22;
+static constexpr uint16_t COMPRESSION_STORED = 0;
+static constexpr uint16_t COMPRESSION_DEFLATE = 8;
+
+// Parsing a header logs every field, batch tools turn that off for the threads they scan with
+static thread_local bool verbose = true;
+// Looking a ROM up in the database hashes all of it, tools that only want the header turn it off
+static thread_local bool rom_db_enabled = true;
+
+#define log_verbose(...)     \
+  do {                       \
+    if (verbose) {           \
+      log_info(__VA_ARGS__); \
+    }                        \
+  } while (0)
 
 static const char *format_type_string[] = {"INES", "NES2.0", "NONE"};
 
@@ -130,6 +162,10 @@ static const char *default_expansion_device_string[] = {
 
 static const char *tv_system_string[] = {"NTSC", "PAL", "None"};
 
+void load_rom_set_verbose(bool enabled) { verbose = enabled; }
+
+void load_rom_set_rom_db(bool enabled) { rom_db_enabled = enabled; }
+
 cartridge_t cart_new(void) {
   return (cartridge_t){
       FORMAT_TYPE_NONE,
@@ -155,26 +191,213 @@ cartridge_t cart_new(void) {
        EXTENDED_CONSOLE_NONE,
        0,
        0,
-       DEFAULT_EXPANSION_DEVICE_UNSPECIFIED}};
+       DEFAULT_EXPANSION_DEVICE_UNSPECIFIED},
+      false,
+      false};
 }
 
 private
 void log_size(const char *name, size_t bytes_read) {
   if (bytes_read > 1024 * 1024) {
-    log_info("%s size: %.2fMiB", name, (double)bytes_read / (1024 * 1024));
+    log_verbose("%s size: %.2fMiB", name, (double)bytes_read / (1024 * 1024));
   } else {
-    log_info("%s size: %.2fKiB", name, (double)bytes_read / 1024);
+    log_verbose("%s size: %.2fKiB", name, (double)bytes_read / 1024);
+  }
+}
+
+// Points the cartridge at a private read only mapping of the file, which saves copying the whole
+// ROM when only a part of it is ever read, e.g. the header when scanning a ROM library
+private
+bool map_rom_file(cartridge_t *cart, FILE *rom_filep, size_t file_size) {
+  void *rom = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fileno(rom_filep), 0);
+  if (rom == MAP_FAILED) {
+    return false;
   }
+
+  cart->rom_data = rom;
+  cart->rom_size = file_size;
+  cart->rom_mapped = true;
+  return true;
+}
+
+[[nodiscard]] private
+bool read_rom_file(arena_t *arena, cartridge_t *cart, FILE *rom_filep, size_t file_size) {
+  uint8_t *rom_data = new (arena, uint8_t, file_size, NOZERO);
+  return_value_if(rom_data == nullptr && file_size > 0, false, "out of memory");
+
+  size_t bytes_read = fread(rom_data, sizeof(uint8_t), file_size, rom_filep);
+  return_value_if(bytes_read < file_size, false, "short read: %zu of %zu bytes", bytes_read,
+                  file_size);
+
+  cart->rom_data = rom_data;
+  cart->rom_size = bytes_read;
+  cart->rom_mapped = false;
+  return true;
+}
+
+// The ROM inside a gzip or zip file
+typedef struct {
+  const uint8_t *data;
+  size_t size;
+  uint16_t method;
+  size_t rom_size;
+  uint32_t crc32;
+} compressed_rom_t;
+
+private
+uint16_t load_le16(const uint8_t *p) { return (uint16_t)(p[0] | p[1] << 8); }
+
+private
+uint32_t load_le32(const uint8_t *p) {
+  return (uint32_t)load_le16(p) | (uint32_t)load_le16(p + 2) << 16;
+}
+
+private
+bool is_gzip(const cartridge_t *cart) {
+  return cart->rom_size >= 2 && cart->rom_data[0] == 0x1F && cart->rom_data[1] == 0x8B;
 }
 
 private
-void cleanup_file(FILE **fp) {
-  if (*fp) {
-    fclose(*fp);
-    *fp = nullptr;
+bool is_zip(const cartridge_t *cart) {
+  return cart->rom_size >= 4 && load_le32(cart->rom_data) == ZIP_LOCAL_HEADER_SIGNATURE;
+}
+
+// Only the first member of a gzip file is read, see RFC 1952
+[[nodiscard]] private
+bool find_gzip_rom(const uint8_t *file, size_t size, compressed_rom_t *rom) {
+  return_value_if(size < GZIP_HEADER_SIZE + GZIP_TRAILER_SIZE, false, "truncated gzip file");
+  return_value_if(file[2] != COMPRESSION_DEFLATE, false, "unknown gzip compression method");
+
+  uint8_t flags = file[3];
+  size_t pos = GZIP_HEADER_SIZE;
+  size_t end = size - GZIP_TRAILER_SIZE;
+
+  if (flags & GZIP_FLAG_EXTRA) {
+    return_value_if(end - pos < 2, false, "truncated gzip header");
+    pos += 2 + load_le16(file + pos);
+  }
+  for (uint8_t flag = GZIP_FLAG_NAME; flag <= GZIP_FLAG_COMMENT; flag <<= 1) {
+    if (flags & flag) {
+      const uint8_t *nul = pos < end ? memchr(file + pos, 0, end - pos) : nullptr;
+      return_value_if(nul == nullptr, false, "truncated gzip header");
+      pos = (size_t)(nul - file) + 1;
+    }
+  }
+  if (flags & GZIP_FLAG_HEADER_CRC) {
+    pos += 2;
+  }
+  return_value_if(pos > end, false, "truncated gzip header");
+
+  *rom = (compressed_rom_t){.data = file + pos,
+                            .size = end - pos,
+                            .method = COMPRESSION_DEFLATE,
+                            .rom_size = load_le32(file + end + 4),
+                            .crc32 = load_le32(file + end)};
+  return true;
+}
+
+// Picks the first .nes file of a zip archive, or its first file if there is none. The central
+// directory is read rather than the local headers as only it has the sizes of streamed entries.
+[[nodiscard]] private
+bool find_zip_rom(const uint8_t *file, size_t size, compressed_rom_t *rom) {
+  return_value_if(size < ZIP_END_SIZE, false, "truncated zip file");
+
+  // the end of central directory record is followed by a comment of up to 64KiB
+  size_t end = size - ZIP_END_SIZE;
+  size_t search_limit = end > UINT16_MAX ? end - UINT16_MAX : 0;
+  while (load_le32(file + end) != ZIP_END_SIGNATURE) {
+    return_value_if(end == search_limit, false, "zip central directory not found");
+    end--;
+  }
+
+  uint16_t entry_count = load_le16(file + end + 10);
+  size_t pos = load_le32(file + end + 16);
+  const uint8_t *chosen = nullptr;
+
+  for (uint16_t i = 0; i < entry_count; i++) {
+    return_value_if(pos > end || end - pos < ZIP_CENTRAL_HEADER_SIZE ||
+                        load_le32(file + pos) != ZIP_CENTRAL_HEADER_SIGNATURE,
+                    false, "corrupt zip central directory");
+
+    const uint8_t *entry = file + pos;
+    uint16_t name_size = load_le16(entry + 28);
+    size_t entry_size = ZIP_CENTRAL_HEADER_SIZE + name_size + load_le16(entry + 30) +
+                        load_le16(entry + 32);
+    return_value_if(end - pos < entry_size, false, "corrupt zip central directory");
+
+    const char *name = (const char *)entry + ZIP_CENTRAL_HEADER_SIZE;
+    bool is_directory = name_size > 0 && name[name_size - 1] == '/';
+    bool is_rom = name_size >= 4 && strncasecmp(name + name_size - 4, ".nes", 4) == 0;
+    if (!is_directory && (chosen == nullptr || is_rom)) {
+      chosen = entry;
+      if (is_rom) {
+        break;
+      }
+    }
+    pos += entry_size;
+  }
+  return_value_if(chosen == nullptr, false, "empty zip file");
+
+  size_t local = load_le32(chosen + 42);
+  return_value_if(local > end || end - local < ZIP_LOCAL_HEADER_SIZE ||
+                      load_le32(file + local) != ZIP_LOCAL_HEADER_SIGNATURE,
+                  false, "corrupt zip local header");
+
+  size_t data = local + ZIP_LOCAL_HEADER_SIZE + load_le16(file + local + 26) +
+                load_le16(file + local + 28);
+  size_t data_size = load_le32(chosen + 20);
+  return_value_if(data > end || end - data < data_size, false, "zip entry lies outside the file");
+
+  *rom = (compressed_rom_t){.data = file + data,
+                            .size = data_size,
+                            .method = load_le16(chosen + 10),
+                            .rom_size = load_le32(chosen + 24),
+                            .crc32 = load_le32(chosen + 16)};
+  return true;
+}
+
+// Replaces the gzip or zip file the cartridge holds with the ROM inside it. The archive stores the
+// size of the ROM, so it is decompressed in a single pass straight into `arena`.
+[[nodiscard]] private
+bool decompress_rom(arena_t *arena, cartridge_t *cart) {
+  compressed_rom_t rom;
+  bool found = is_gzip(cart) ? find_gzip_rom(cart->rom_data, cart->rom_size, &rom)
+                             : find_zip_rom(cart->rom_data, cart->rom_size, &rom);
+  return_value_if(!found, false, "cannot find a ROM in the archive");
+  return_value_if(rom.rom_size > MAX_ROM_SIZE, false, ERR_ROM_FILE_TOO_LARGE);
+
+  uint8_t *rom_data = new (arena, uint8_t, rom.rom_size, NOZERO);
+  return_value_if(rom_data == nullptr && rom.rom_size > 0, false, "out of memory");
+
+  size_t written = 0;
+  switch (rom.method) {
+    case COMPRESSION_STORED:
+      return_value_if(rom.size != rom.rom_size, false, "corrupt stored zip entry");
+      memcpy(rom_data, rom.data, rom.size);
+      written = rom.size;
+      break;
+    case COMPRESSION_DEFLATE:
+      return_value_if(!inflate(rom.data, rom.size, rom_data, rom.rom_size, &written), false,
+                      "cannot decompress the ROM");
+      break;
+    default:
+      log_error("unsupported compression method %d", rom.method);
+      return false;
   }
+
+  return_value_if(written != rom.rom_size, false, "ROM is %zu bytes instead of %zu", written,
+                  rom.rom_size);
+  return_value_if(crc32_update(0, rom_data, written) != rom.crc32, false, "ROM CRC mismatch");
+
+  cart_release(cart);
+  cart->rom_data = rom_data;
+  cart->rom_size = written;
+  return true;
 }
 
+// The file is mapped when possible and copied into `arena` otherwise, e.g. on file systems that
+// cannot map files. gzip and zip files are decompressed into `arena`. Either way cart_release()
+// has to be called once the cartridge is not used anymore.
 bool load_rom_file(arena_t *arena, cartridge_t *cart, const char *file_path) {
   return_value_if(file_path == nullptr, false, ERR_NULL_FILEPATH);
 
@@ -185,22 +408,40 @@ bool load_rom_file(arena_t *arena, cartridge_t *cart, const char *file_path) {
 
   // get the file size
   struct stat st;
-  stat(file_path, &st);
+  return_value_if(fstat(fileno(rom_filep), &st) != 0, false, "cannot stat file: %s", file_path);
   off_t file_size = st.st_size;
   return_value_if(file_size < 0, false, ERR_INVALID_FILE_SIZE);
   return_value_if(file_size > MAX_ROM_SIZE, false, ERR_ROM_FILE_TOO_LARGE);
 
-  cart->rom_data = new (arena, uint8_t, file_size);
-  size_t bytes_read = fread(cart->rom_data, sizeof(uint8_t), file_size, rom_filep);
-  return_value_if(bytes_read < (size_t)file_size, false, "cannot read file: %s", file_path);
+  // the mapping stays valid after the file is closed
+  if (file_size == 0 || !map_rom_file(cart, rom_filep, (size_t)file_size)) {
+    return_value_if(!read_rom_file(arena, cart, rom_filep, (size_t)file_size), false,
+                    "cannot read file: %s", file_path);
+  }
 
-  cart->rom_size = bytes_read;
-  log_info("Loaded ROM: %s", get_filename_from_path(file_path));
-  log_size("ROM", bytes_read);
+  if ((is_gzip(cart) || is_zip(cart)) && !decompress_rom(arena, cart)) {
+    cart_release(cart);
+    log_error("cannot read compressed file: %s", file_path);
+    return false;
+  }
+
+  log_verbose("Loaded ROM: %s", get_filename_from_path(file_path));
+  log_size("ROM", cart->rom_size);
 
   return true;
 }
 
+// Unmaps the ROM if load_rom_file() mapped it, an arena copy is freed along with its arena
+void cart_release(cartridge_t *cart) {
+  if (cart->rom_mapped) {
+    munmap((void *)cart->rom_data, cart->rom_size);
+  }
+
+  cart->rom_data = nullptr;
+  cart->rom_size = 0;
+  cart->rom_mapped = false;
+}
+
 [[nodiscard]] private
 bool ines2_set_prg_rom_size(cartridge_t *cart, const uint8_t *header) {
   uint8_t prg_lsb = header[4];
@@ -250,13 +491,13 @@ void ines2_set_mapper_number(cartridge_t *cart, const uint8_t *header) {
   cart->ines2_header.mapper_number =
       (uint16_t)((mapper_bits_8_11 << 8) | (mapper_bits_4_7 << 4) | mapper_bits_0_3);
 
-  log_info("Mapper Number: %d", cart->ines2_header.mapper_number);
+  log_verbose("Mapper Number: %d", cart->ines2_header.mapper_number);
 }
 
 private
 void ines2_set_submapper_number(cartridge_t *cart, const uint8_t *header) {
   cart->ines2_header.submapper_number = get_upper_4_bits(header[8]);
-  log_info("Submapper Number: %d", cart->ines2_header.submapper_number);
+  log_verbose("Submapper Number: %d", cart->ines2_header.submapper_number);
 }
 
 private
@@ -264,30 +505,30 @@ void ines2_set_nametable_layout(cartridge_t *cart, const uint8_t *header) {
   cart->ines2_header.hard_wired_nametable_layout = get_0th_bit(header[6]);
   cart->ines2_header.alternative_nametables = get_3rd_bit(header[6]);
 
-  log_info("Hard wired nametable layout type: %s",
-           hard_wired_nametable_layout_string[cart->ines2_header.hard_wired_nametable_layout]);
+  log_verbose("Hard wired nametable layout type: %s",
+              hard_wired_nametable_layout_string[cart->ines2_header.hard_wired_nametable_layout]);
 
-  log_info("Alternative nametables present? %s",
-           cart->ines2_header.alternative_nametables ? "Yes" : "No");
+  log_verbose("Alternative nametables present? %s",
+              cart->ines2_header.alternative_nametables ? "Yes" : "No");
 }
 
 private
 void ines2_check_battery_present(cartridge_t *cart, const uint8_t *header) {
   cart->ines2_header.battery_present = get_1st_bit(header[6]);
-  log_info("Is \"Battery\" and other non-volatile memory present? %s",
-           cart->ines2_header.battery_present ? "Yes" : "No");
+  log_verbose("Is \"Battery\" and other non-volatile memory present? %s",
+              cart->ines2_header.battery_present ? "Yes" : "No");
 }
 
 private
 void ines2_check_trainer_area_present(cartridge_t *cart, const uint8_t *header) {
   cart->ines2_header.trainer_area_exists = get_2nd_bit(header[6]);
-  log_info("Does trainer area exist? %s", cart->ines2_header.trainer_area_exists ? "Yes" : "No");
+  log_verbose("Does trainer area exist? %s", cart->ines2_header.trainer_area_exists ? "Yes" : "No");
 }
 
 private
 void ines2_set_console_type(cartridge_t *cart, const uint8_t *header) {
   cart->ines2_header.console_type = get_lower_2_bits(header[7]);
-  log_info("Console type: %s", console_type_string[cart->ines2_header.console_type]);
+  log_verbose("Console type: %s", console_type_string[cart->ines2_header.console_type]);
 }
 
 private
@@ -326,7 +567,7 @@ void ines2_set_chr_ram_sizes(cartridge_t *cart, const uint8_t *header) {
 private
 void ines2_set_cpu_ppu_timing(cartridge_t *cart, const uint8_t *header) {
   cart->ines2_header.cpu_ppu_timing = get_lower_2_bits(header[12]);
-  log_info("CPU/PPU timing mode: %s", cpu_ppu_timing_string[cart->ines2_header.cpu_ppu_timing]);
+  log_verbose("CPU/PPU timing mode: %s", cpu_ppu_timing_string[cart->ines2_header.cpu_ppu_timing]);
 }
 
 private
@@ -339,7 +580,7 @@ void detect_rom_format(cartridge_t *cart, const uint8_t *header) {
     cart->format_type = FORMAT_TYPE_INES2;
   }
 
-  log_info("ROM Format: %s", format_type_string[cart->format_type]);
+  log_verbose("ROM Format: %s", format_type_string[cart->format_type]);
 }
 
 private
@@ -349,15 +590,15 @@ void ines2_set_extended_system_type(cartridge_t *cart, const uint8_t *header) {
       cart->ines2_header.vs_ppu_type = get_lower_4_bits(header[13]);
       cart->ines2_header.vs_hardware_type = get_upper_4_bits(header[13]);
 
-      log_info("Vs. PPU Type: %s", vs_ppu_type_string[cart->ines2_header.vs_ppu_type]);
-      log_info("Vs. Hardware Type: %s",
-               vs_hardware_type_string[cart->ines2_header.vs_hardware_type]);
+      log_verbose("Vs. PPU Type: %s", vs_ppu_type_string[cart->ines2_header.vs_ppu_type]);
+      log_verbose("Vs. Hardware Type: %s",
+                  vs_hardware_type_string[cart->ines2_header.vs_hardware_type]);
       break;
 
     case CONSOLE_EXTENDED:
       cart->ines2_header.extended_console_type = get_lower_4_bits(header[13]);
-      log_info("Extended Console Type: %s",
-               extended_console_type_string[cart->ines2_header.extended_console_type]);
+      log_verbose("Extended Console Type: %s",
+                  extended_console_type_string[cart->ines2_header.extended_console_type]);
       break;
 
     default:
@@ -374,7 +615,8 @@ bool ines2_set_misc_rom_area_size(cartridge_t *cart, const uint8_t *header) {
   // what effect it will have on the rest of the code. इतनी माथापच्ची नहीं करनी ।
   ptrdiff_t signed_rom_size = cart->rom_size;
   ptrdiff_t signed_header_size = HEADER_SIZE;
-  ptrdiff_t signed_trainer_area_size = cart->ines2_header.trainer_area_exists ? 512 : 0;
+  ptrdiff_t signed_trainer_area_size =
+      cart->ines2_header.trainer_area_exists ? TRAINER_AREA_SIZE : 0;
   ptrdiff_t signed_prg_rom_size = cart->ines2_header.prg_rom_size;
   ptrdiff_t signed_chr_rom_size = cart->ines2_header.chr_rom_size;
 
@@ -389,8 +631,8 @@ bool ines2_set_misc_rom_area_size(cartridge_t *cart, const uint8_t *header) {
 
   cart->ines2_header.misc_rom_area_size = signed_rom_size - total_other_sizes;
 
-  log_info("Number of miscellaneous ROMs present: %d", cart->ines2_header.misc_rom_number);
-  log_info("Miscellaneous ROM area size: %ld", cart->ines2_header.misc_rom_area_size);
+  log_verbose("Number of miscellaneous ROMs present: %d", cart->ines2_header.misc_rom_number);
+  log_verbose("Miscellaneous ROM area size: %ld", cart->ines2_header.misc_rom_area_size);
 
   return true;
 }
@@ -398,8 +640,8 @@ bool ines2_set_misc_rom_area_size(cartridge_t *cart, const uint8_t *header) {
 private
 void ines2_set_default_expansion_device(cartridge_t *cart, const uint8_t *header) {
   cart->ines2_header.default_expansion_device = get_lower_6_bits(header[15]);
-  log_info("Default Expansion Device: %s",
-           default_expansion_device_string[cart->ines2_header.default_expansion_device]);
+  log_verbose("Default Expansion Device: %s",
+              default_expansion_device_string[cart->ines2_header.default_expansion_device]);
 }
 
 private
@@ -414,7 +656,7 @@ void ines_set_chr_rom_size(cartridge_t *cart, const uint8_t *header) {
   cart->ines_header.chr_ram_exists = (header[5] == 0) ? true : false;
 
   log_size("CHR ROM", cart->ines_header.chr_rom_size);
-  log_info("CHR RAM exists? %s", cart->ines_header.chr_ram_exists ? "Yes" : "No");
+  log_verbose("CHR RAM exists? %s", cart->ines_header.chr_ram_exists ? "Yes" : "No");
 }
 
 private
@@ -422,24 +664,24 @@ void ines_set_nametable_layout(cartridge_t *cart, const uint8_t *header) {
   cart->ines_header.hard_wired_nametable_layout = get_0th_bit(header[6]);
   cart->ines_header.alternative_nametables = get_3rd_bit(header[6]);
 
-  log_info("Hard wired nametable layout type: %s",
-           hard_wired_nametable_layout_string[cart->ines_header.hard_wired_nametable_layout]);
+  log_verbose("Hard wired nametable layout type: %s",
+              hard_wired_nametable_layout_string[cart->ines_header.hard_wired_nametable_layout]);
 
-  log_info("Alternative nametables present? %s",
-           cart->ines_header.alternative_nametables ? "Yes" : "No");
+  log_verbose("Alternative nametables present? %s",
+              cart->ines_header.alternative_nametables ? "Yes" : "No");
 }
 
 private
 void ines_check_battery_present(cartridge_t *cart, const uint8_t *header) {
   cart->ines_header.battery_present = get_1st_bit(header[6]);
-  log_info("Is \"Battery\" and other non-volatile memory present? %s",
-           cart->ines_header.battery_present ? "Yes" : "No");
+  log_verbose("Is \"Battery\" and other non-volatile memory present? %s",
+              cart->ines_header.battery_present ? "Yes" : "No");
 }
 
 private
 void ines_check_trainer_area_present(cartridge_t *cart, const uint8_t *header) {
   cart->ines_header.trainer_area_exists = get_2nd_bit(header[6]);
-  log_info("Does trainer area exist? %s", cart->ines_header.trainer_area_exists ? "Yes" : "No");
+  log_verbose("Does trainer area exist? %s", cart->ines_header.trainer_area_exists ? "Yes" : "No");
 }
 
 private
@@ -449,7 +691,7 @@ void ines_set_mapper_number(cartridge_t *cart, const uint8_t *header) {
 
   cart->ines_header.mapper_number = (uint8_t)(mapper_hi << 4) | mapper_lo;
 
-  log_info("Mapper Number: %d", cart->ines_header.mapper_number);
+  log_verbose("Mapper Number: %d", cart->ines_header.mapper_number);
 }
 
 private
@@ -460,7 +702,7 @@ void ines_set_console_type(cartridge_t *cart, const uint8_t *header) {
     log_warn("Console type cannot be both VS Unisystem and PlayChoice-10 simultaneously");
   }
 
-  log_info("Console type: %s", console_type_string[cart->ines_header.console_type]);
+  log_verbose("Console type: %s", console_type_string[cart->ines_header.console_type]);
 }
 
 private
@@ -473,11 +715,51 @@ void ines_set_prg_ram_size(cartridge_t *cart, const uint8_t *header) {
 private
 void ines_set_tv_system(cartridge_t *cart, const uint8_t *header) {
   cart->ines_header.tv_system = get_0th_bit(header[9]);
-  log_info("TV system: %s", tv_system_string[cart->ines_header.tv_system]);
+  log_verbose("TV system: %s", tv_system_string[cart->ines_header.tv_system]);
+}
+
+// iNES headers often have the wrong mapper or mirroring, ROMs known to the database get the
+// fields it has for them. NES 2.0 headers are trusted.
+private
+void ines_apply_rom_db(cartridge_t *cart) {
+  const uint8_t *prg_rom;
+  const uint8_t *chr_rom;
+  size_t prg_rom_size;
+  size_t chr_rom_size;
+
+  if (!rom_db_enabled || rom_db_size() == 0 ||
+      !cart_get_prg_rom(cart, &prg_rom, &prg_rom_size) ||
+      !cart_get_chr_rom(cart, &chr_rom, &chr_rom_size)) {
+    return;
+  }
+
+  uint32_t crc = crc32_update(crc32_update(0, prg_rom, prg_rom_size), chr_rom, chr_rom_size);
+  const rom_db_entry_t *entry = rom_db_find(crc);
+  if (entry == nullptr) {
+    return;
+  }
+
+  ines_header_t *header = &cart->ines_header;
+  if (entry->mapper_number > UINT8_MAX) {
+    log_warn("ROM database mapper %d does not fit an iNES header", entry->mapper_number);
+    return;
+  }
+
+  header->mapper_number = (uint8_t)entry->mapper_number;
+  header->hard_wired_nametable_layout = entry->hard_wired_nametable_layout;
+  header->alternative_nametables = entry->alternative_nametables;
+  header->battery_present = entry->battery_present;
+  header->tv_system = entry->cpu_ppu_timing == TIMING_PAL ? TV_SYSTEM_PAL : TV_SYSTEM_NTSC;
+  cart->header_corrected = true;
+
+  log_verbose("Header corrected from the ROM database (CRC32 %08x): mapper %d, %s", crc,
+              header->mapper_number,
+              hard_wired_nametable_layout_string[header->hard_wired_nametable_layout]);
 }
 
 bool fill_header(cartridge_t *cart) {
   return_value_if(cart->rom_data == nullptr, false, "ROM Data is not initialized");
+  return_value_if(cart->rom_size < HEADER_SIZE, false, "ROM is smaller than its header");
 
   // ines and nes2.0 formats have 16B header size
   uint8_t header[HEADER_SIZE] = {};
@@ -498,12 +780,14 @@ bool fill_header(cartridge_t *cart) {
       ines_set_console_type(cart, header);
       ines_set_prg_ram_size(cart, header);
       ines_set_tv_system(cart, header);
+      ines_apply_rom_db(cart);
+      out = true;
       break;
     case FORMAT_TYPE_INES2:
       ines2_check_trainer_area_present(cart, header);
       out = ines2_set_prg_rom_size(cart, header);
-      out = ines2_set_chr_rom_size(cart, header);
-      out = ines2_set_misc_rom_area_size(cart, header);
+      out = out && ines2_set_chr_rom_size(cart, header);
+      out = out && ines2_set_misc_rom_area_size(cart, header);
       ines2_set_mapper_number(cart, header);
       ines2_set_submapper_number(cart, header);
       ines2_set_nametable_layout(cart, header);
@@ -522,3 +806,51 @@ bool fill_header(cartridge_t *cart) {
   return_value_if(!out, false, "Could not set one or more ROM area sizes");
   return true;
 }
+
+// PRG ROM follows the header and the optional trainer area, CHR ROM follows PRG ROM
+private
+size_t get_prg_rom_offset(const cartridge_t *cart) {
+  bool trainer_area_exists = cart->format_type == FORMAT_TYPE_INES2
+                                 ? cart->ines2_header.trainer_area_exists
+                                 : cart->ines_header.trainer_area_exists;
+
+  return HEADER_SIZE + (trainer_area_exists ? TRAINER_AREA_SIZE : 0);
+}
+
+private
+size_t get_prg_rom_size(const cartridge_t *cart) {
+  return cart->format_type == FORMAT_TYPE_INES2 ? cart->ines2_header.prg_rom_size
+                                                : cart->ines_header.prg_rom_size;
+}
+
+private
+size_t get_chr_rom_size(const cartridge_t *cart) {
+  return cart->format_type == FORMAT_TYPE_INES2 ? cart->ines2_header.chr_rom_size
+                                                : cart->ines_header.chr_rom_size;
+}
+
+bool cart_get_prg_rom(const cartridge_t *cart, const uint8_t **prg_rom, size_t *prg_rom_size) {
+  return_value_if(cart->format_type == FORMAT_TYPE_NONE, false, ERR_ROM_TYPE_NOT_SUPPORTED);
+
+  size_t offset = get_prg_rom_offset(cart);
+  size_t size = get_prg_rom_size(cart);
+  return_value_if(size > cart->rom_size || offset > cart->rom_size - size, false,
+                  "PRG ROM lies outside of the ROM file");
+
+  *prg_rom = cart->rom_data + offset;
+  *prg_rom_size = size;
+  return true;
+}
+
+bool cart_get_chr_rom(const cartridge_t *cart, const uint8_t **chr_rom, size_t *chr_rom_size) {
+  return_value_if(cart->format_type == FORMAT_TYPE_NONE, false, ERR_ROM_TYPE_NOT_SUPPORTED);
+
+  size_t offset = get_prg_rom_offset(cart) + get_prg_rom_size(cart);
+  size_t size = get_chr_rom_size(cart);
+  return_value_if(size > cart->rom_size || offset > cart->rom_size - size, false,
+                  "CHR ROM lies outside of the ROM file");
+
+  *chr_rom = cart->rom_data + offset;
+  *chr_rom_size = size;
+  return true;
+}
@@ -208,12 +208,21 @@ typedef struct {
 
 typedef struct {
   format_type_t format_type;
-  uint8_t *rom_data;
+  const uint8_t *rom_data;
   size_t rom_size;
   ines_header_t ines_header;
   ines2_header_t ines2_header;
+  bool rom_mapped;        // rom_data is a read only mapping of the file, see cart_release()
+  bool header_corrected;  // the iNES header was overridden from the ROM database, see rom_db.h
 } cartridge_t;
 
+void load_rom_set_verbose(bool enabled);
+void load_rom_set_rom_db(bool enabled);
 cartridge_t cart_new(void);
 [[nodiscard]] bool load_rom_file(arena_t *arena, cartridge_t *cart, const char *file_path);
+void cart_release(cartridge_t *cart);
 [[nodiscard]] bool fill_header(cartridge_t *cart);
+[[nodiscard]] bool cart_get_prg_rom(const cartridge_t *cart, const uint8_t **prg_rom,
+                                    size_t *prg_rom_size);
+[[nodiscard]] bool cart_get_chr_rom(const cartridge_t *cart, const uint8_t **chr_rom,
+                                    size_t *chr_rom_size);
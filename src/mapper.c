@@ -0,0 +1,470 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#include "mapper.h"
+
+#include "profile.h"
+#include "utils.h"
+
+static constexpr uint16_t PRG_RAM_START = 0x6000;
+static constexpr uint16_t PRG_RAM_END = 0x7FFF;
+static constexpr uint16_t PRG_ROM_START = 0x8000;
+static constexpr uint16_t PRG_ROM_END = 0xFFFF;
+static constexpr uint32_t KIB = 1024;
+
+// Maps PRG ROM bank `bank`, `size` bytes long, at `addr`. Negative banks count from the end of
+// the ROM and banks past it wrap around, like the address lines a smaller ROM leaves unconnected.
+private
+void map_prg(mapper_t *mapper, uint16_t addr, uint32_t size, int32_t bank) {
+  int64_t bank_count = (int64_t)(mapper->prg_rom_size / size);
+  uint16_t end = (uint16_t)(addr + size - 1);
+
+  if (bank_count == 0) {
+    bus_map_read_memory(&mapper->cpu->bus, addr, end, mapper->prg_rom, mapper->prg_rom_size);
+    return;
+  }
+
+  int64_t index = (bank % bank_count + bank_count) % bank_count;
+#ifdef NES_STATS
+  mapper->bank_switches += mapper->cpu->bus.read_pages[addr >> 8] != mapper->prg_rom + index * size;
+#endif
+  bus_map_read_memory(&mapper->cpu->bus, addr, end, mapper->prg_rom + index * size, size);
+}
+
+// Maps CHR bank `bank`, `page_count` 1KiB pages long, starting at PPU page `page`
+private
+void map_chr(mapper_t *mapper, uint8_t page, uint8_t page_count, uint32_t bank) {
+  size_t size = page_count * PPU_CHR_PAGE_SIZE;
+  size_t bank_count = mapper->chr_size / size;
+  const uint8_t *chr = mapper->chr + (bank_count ? bank % bank_count : 0) * size;
+#ifdef NES_STATS
+  mapper->bank_switches += mapper->ppu->chr_pages[page] != chr;
+#endif
+
+  for (uint8_t i = 0; i < page_count; i++) {
+    ppu_set_chr_page(mapper->ppu, page + i, chr + (i * PPU_CHR_PAGE_SIZE) % mapper->chr_size);
+  }
+}
+
+private
+void set_mirroring(mapper_t *mapper, mirroring_t mirroring) {
+  // four screen VRAM on the board overrides whatever the mapper selects
+  if (mapper->hard_wired_mirroring != MIRRORING_FOUR_SCREEN &&
+      mapper->ppu->state.mirroring != mirroring) {
+    ppu_set_mirroring(mapper->ppu, mirroring);
+  }
+}
+
+private
+uint64_t now(const mapper_t *mapper) {
+  return mapper->cpu->cycles * mapper->ppu->master_clocks_per_cpu_cycle;
+}
+
+private
+void write_nothing(void *ctx, uint16_t addr, uint8_t val) {
+  (void)ctx;
+  (void)addr;
+  (void)val;
+}
+
+/* NROM, https://www.nesdev.org/wiki/NROM */
+
+private
+void nrom_update_banks(mapper_t *mapper) {
+  // 16KiB carts are mirrored into $C000-$FFFF
+  map_prg(mapper, 0x8000, 16 * KIB, 0);
+  map_prg(mapper, 0xC000, 16 * KIB, -1);
+  map_chr(mapper, 0, 8, 0);
+}
+
+/* MMC1, https://www.nesdev.org/wiki/MMC1 */
+
+private
+void mmc1_power_on(mapper_t *mapper) {
+  mmc1_t *mmc1 = &mapper->state.mmc1;
+
+  // the last PRG bank is fixed at $C000 so that the reset vector is found
+  mmc1->control = 0x0C;
+  mmc1->last_write = UINT64_MAX;
+}
+
+private
+void mmc1_update_banks(mapper_t *mapper) {
+  static constexpr mirroring_t mirrorings[] = {
+      MIRRORING_SINGLE_SCREEN_LOW, MIRRORING_SINGLE_SCREEN_HIGH, MIRRORING_VERTICAL,
+      MIRRORING_HORIZONTAL};
+  mmc1_t *mmc1 = &mapper->state.mmc1;
+
+  set_mirroring(mapper, mirrorings[get_lower_2_bits(mmc1->control)]);
+
+  // 512KiB boards select the 256KiB half with bit 4 of the CHR bank, it is ignored by the others
+  // as map_prg() wraps around
+  uint8_t outer = mmc1->chr_banks[0] & 0x10;
+  uint8_t bank = outer | get_lower_4_bits(mmc1->prg_bank);
+
+  switch ((mmc1->control >> 2) & 0x03) {
+    case 0:
+    case 1:
+      map_prg(mapper, 0x8000, 32 * KIB, bank >> 1);
+      break;
+    case 2:
+      map_prg(mapper, 0x8000, 16 * KIB, outer);
+      map_prg(mapper, 0xC000, 16 * KIB, bank);
+      break;
+    default:
+      map_prg(mapper, 0x8000, 16 * KIB, bank);
+      map_prg(mapper, 0xC000, 16 * KIB, outer | 0x0F);
+  }
+
+  if (mmc1->control & 0x10) {
+    map_chr(mapper, 0, 4, mmc1->chr_banks[0]);
+    map_chr(mapper, 4, 4, mmc1->chr_banks[1]);
+  } else {
+    map_chr(mapper, 0, 8, mmc1->chr_banks[0] >> 1);
+  }
+}
+
+// The registers are loaded one bit at a time through a shift register, the fifth write picks the
+// register from its address
+private
+void mmc1_write(void *ctx, uint16_t addr, uint8_t val) {
+  mapper_t *mapper = ctx;
+  mmc1_t *mmc1 = &mapper->state.mmc1;
+
+  // the dummy write of read-modify-write instructions is right before the real one, the board
+  // only sees the first of them
+  bool consecutive = mapper->cpu->cycles == mmc1->last_write + 1;
+  mmc1->last_write = mapper->cpu->cycles;
+  if (consecutive) {
+    return;
+  }
+
+  if (check_if_bit7_set(val)) {
+    mmc1->shift = 0;
+    mmc1->shift_count = 0;
+    mmc1->control |= 0x0C;
+    mmc1_update_banks(mapper);
+    return;
+  }
+
+  mmc1->shift |= (uint8_t)(get_0th_bit(val) << mmc1->shift_count++);
+  if (mmc1->shift_count < 5) {
+    return;
+  }
+
+  switch ((addr >> 13) & 0x03) {
+    case 0:
+      mmc1->control = mmc1->shift;
+      break;
+    case 1:
+      mmc1->chr_banks[0] = mmc1->shift;
+      break;
+    case 2:
+      mmc1->chr_banks[1] = mmc1->shift;
+      break;
+    default:
+      mmc1->prg_bank = mmc1->shift;
+  }
+
+  mmc1->shift = 0;
+  mmc1->shift_count = 0;
+  mmc1_update_banks(mapper);
+}
+
+/* UxROM, https://www.nesdev.org/wiki/UxROM */
+
+private
+void uxrom_update_banks(mapper_t *mapper) {
+  map_prg(mapper, 0x8000, 16 * KIB, mapper->state.bank);
+  map_prg(mapper, 0xC000, 16 * KIB, -1);
+  map_chr(mapper, 0, 8, 0);
+}
+
+private
+void uxrom_write(void *ctx, uint16_t addr, uint8_t val) {
+  (void)addr;
+  mapper_t *mapper = ctx;
+
+  mapper->state.bank = val;
+  map_prg(mapper, 0x8000, 16 * KIB, val);
+}
+
+/* CNROM, https://www.nesdev.org/wiki/CNROM */
+
+private
+void cnrom_update_banks(mapper_t *mapper) {
+  map_prg(mapper, 0x8000, 16 * KIB, 0);
+  map_prg(mapper, 0xC000, 16 * KIB, -1);
+  map_chr(mapper, 0, 8, mapper->state.bank);
+}
+
+private
+void cnrom_write(void *ctx, uint16_t addr, uint8_t val) {
+  (void)addr;
+  mapper_t *mapper = ctx;
+
+  mapper->state.bank = val;
+  map_chr(mapper, 0, 8, val);
+}
+
+/* MMC3, https://www.nesdev.org/wiki/MMC3 */
+
+// Clocks the scanline counter once for every A12 rise the PPU has made up to `now`
+private
+void mmc3_clock_counter(mapper_t *mapper, uint64_t now) {
+  mmc3_t *mmc3 = &mapper->state.mmc3;
+  uint64_t rises = ppu_a12_rises(mapper->ppu, now);
+  uint64_t clocks = rises - mmc3->a12_rises;
+
+  mmc3->a12_rises = rises;
+  while (clocks > 0) {
+    if (mmc3->irq_counter == 0 || mmc3->irq_reload) {
+      mmc3->irq_counter = mmc3->irq_latch;
+      mmc3->irq_reload = false;
+      clocks--;
+    } else {
+      uint64_t steps = clocks < mmc3->irq_counter ? clocks : mmc3->irq_counter;
+      mmc3->irq_counter -= (uint8_t)steps;
+      clocks -= steps;
+    }
+
+    if (mmc3->irq_counter == 0) {
+      if (mmc3->irq_enabled) {
+        cpu_set_irq(mapper->cpu, IRQ_SOURCE_MAPPER, true);
+      }
+      // a latch of 0 keeps the counter at 0, the remaining clocks change nothing
+      if (mmc3->irq_latch == 0) {
+        break;
+      }
+    }
+  }
+}
+
+// Schedules EVENT_MAPPER_IRQ at the A12 rise that brings the counter down to 0, the counter is
+// never clocked in between. When a $C000-$E001 write moves it before the deadline the CPU is
+// running to, the scheduler has the CPU stop there, see tools/irq_timing_check.
+private
+void mmc3_schedule_irq(mapper_t *mapper) {
+  mmc3_t *mmc3 = &mapper->state.mmc3;
+
+  if (!mmc3->irq_enabled) {
+    scheduler_cancel(mapper->scheduler, EVENT_MAPPER_IRQ);
+    return;
+  }
+
+  uint32_t clocks = (mmc3->irq_counter == 0 || mmc3->irq_reload) ? mmc3->irq_latch + 1u
+                                                                  : mmc3->irq_counter;
+  scheduler_schedule(mapper->scheduler, EVENT_MAPPER_IRQ,
+                     ppu_a12_rise_time(mapper->ppu, clocks));
+}
+
+// If rendering was off the counter did not get to 0 yet, the next rise is tried again
+private
+void mmc3_on_irq(void *ctx, uint64_t when) {
+  mapper_t *mapper = ctx;
+  profile_component_t previous = profile_enter(PROFILE_MAPPER);
+
+  mmc3_clock_counter(mapper, when);
+  mmc3_schedule_irq(mapper);
+  profile_leave(previous);
+}
+
+private
+void mmc3_power_on(mapper_t *mapper) {
+  mapper->state.mmc3.a12_rises = mapper->ppu->state.a12_rises;
+  scheduler_set_handler(mapper->scheduler, EVENT_MAPPER_IRQ, mmc3_on_irq, mapper);
+}
+
+private
+void mmc3_update_banks(mapper_t *mapper) {
+  mmc3_t *mmc3 = &mapper->state.mmc3;
+  const uint8_t *banks = mmc3->banks;
+  bool prg_swapped = check_if_bit6_set(mmc3->bank_select);
+
+  map_prg(mapper, 0x8000, 8 * KIB, prg_swapped ? -2 : banks[6]);
+  map_prg(mapper, 0xA000, 8 * KIB, banks[7]);
+  map_prg(mapper, 0xC000, 8 * KIB, prg_swapped ? banks[6] : -2);
+  map_prg(mapper, 0xE000, 8 * KIB, -1);
+
+  // two 2KiB banks and four 1KiB banks, bit 7 swaps the pattern tables they go to
+  uint8_t wide = check_if_bit7_set(mmc3->bank_select) ? 4 : 0;
+  uint8_t narrow = wide ^ 4;
+  map_chr(mapper, wide, 2, banks[0] >> 1);
+  map_chr(mapper, wide + 2, 2, banks[1] >> 1);
+  for (uint8_t i = 0; i < 4; i++) {
+    map_chr(mapper, narrow + i, 1, banks[2 + i]);
+  }
+
+  set_mirroring(mapper, mmc3->horizontal ? MIRRORING_HORIZONTAL : MIRRORING_VERTICAL);
+}
+
+private
+void mmc3_write(void *ctx, uint16_t addr, uint8_t val) {
+  mapper_t *mapper = ctx;
+  mmc3_t *mmc3 = &mapper->state.mmc3;
+
+  // the IRQ registers change how the coming A12 rises count, account for the past ones first
+  if (addr >= 0xC000) {
+    mmc3_clock_counter(mapper, now(mapper));
+  }
+
+  switch (addr & 0xE001) {
+    case 0x8000:
+      mmc3->bank_select = val;
+      mmc3_update_banks(mapper);
+      break;
+    case 0x8001:
+      mmc3->banks[mmc3->bank_select & 0x07] = val;
+      mmc3_update_banks(mapper);
+      break;
+    case 0xA000:
+      mmc3->horizontal = check_if_bit0_set(val);
+      mmc3_update_banks(mapper);
+      break;
+    case 0xC000:
+      mmc3->irq_latch = val;
+      break;
+    case 0xC001:
+      mmc3->irq_counter = 0;
+      mmc3->irq_reload = true;
+      break;
+    case 0xE000:
+      mmc3->irq_enabled = false;
+      cpu_set_irq(mapper->cpu, IRQ_SOURCE_MAPPER, false);
+      break;
+    case 0xE001:
+      mmc3->irq_enabled = true;
+      break;
+    default:
+      // $A001 protects PRG RAM, which is not emulated as boards disagree on it
+      break;
+  }
+
+  if (addr >= 0xC000) {
+    mmc3_schedule_irq(mapper);
+  }
+}
+
+static const mapper_info_t mappers[] = {
+    {.number = 0, .name = "NROM", .write = write_nothing, .update_banks = nrom_update_banks},
+    {.number = 1,
+     .name = "MMC1",
+     .power_on = mmc1_power_on,
+     .write = mmc1_write,
+     .update_banks = mmc1_update_banks},
+    {.number = 2, .name = "UxROM", .write = uxrom_write, .update_banks = uxrom_update_banks},
+    {.number = 3, .name = "CNROM", .write = cnrom_write, .update_banks = cnrom_update_banks},
+    {.number = 4,
+     .name = "MMC3",
+     .power_on = mmc3_power_on,
+     .write = mmc3_write,
+     .update_banks = mmc3_update_banks},
+};
+
+#ifdef NES_PROFILE
+// Registered in place of the board's own write handler, so that every board is profiled
+private
+void profiled_write(void *ctx, uint16_t addr, uint8_t val) {
+  profile_component_t previous = profile_enter(PROFILE_MAPPER);
+  ((mapper_t *)ctx)->info->write(ctx, addr, val);
+  profile_leave(previous);
+}
+#endif
+
+private
+const mapper_info_t *find_mapper(uint16_t number) {
+  for (size_t i = 0; i < sizeof(mappers) / sizeof(mappers[0]); i++) {
+    if (mappers[i].number == number) {
+      return &mappers[i];
+    }
+  }
+  return nullptr;
+}
+
+private
+mirroring_t get_hard_wired_mirroring(const cartridge_t *cart) {
+  bool ines2 = cart->format_type == FORMAT_TYPE_INES2;
+  hard_wired_nametable_layout_t layout = ines2 ? cart->ines2_header.hard_wired_nametable_layout
+                                               : cart->ines_header.hard_wired_nametable_layout;
+  bool alternative = ines2 ? cart->ines2_header.alternative_nametables
+                           : cart->ines_header.alternative_nametables;
+
+  // nametables arranged vertically are mirrored horizontally and vice versa, the boards here use
+  // the alternative nametables bit for four screen VRAM
+  if (alternative) {
+    return MIRRORING_FOUR_SCREEN;
+  }
+  return layout == NAMETABLE_VERTICAL ? MIRRORING_HORIZONTAL : MIRRORING_VERTICAL;
+}
+
+// Connects the board of `cart` to the CPU bus and the PPU and maps its power on banks
+bool mapper_init(mapper_t *mapper, const cartridge_t *cart, cpu_t *cpu, ppu_t *ppu,
+                 scheduler_t *scheduler) {
+  uint16_t number = cart->format_type == FORMAT_TYPE_INES2 ? cart->ines2_header.mapper_number
+                                                           : cart->ines_header.mapper_number;
+  const mapper_info_t *info = find_mapper(number);
+  return_value_if(info == nullptr, false, "Mapper %d is not supported yet", number);
+
+  const uint8_t *prg_rom;
+  const uint8_t *chr_rom;
+  size_t prg_rom_size;
+  size_t chr_rom_size;
+  return_value_if(!cart_get_prg_rom(cart, &prg_rom, &prg_rom_size), false,
+                  "Could not locate PRG ROM");
+  return_value_if(!cart_get_chr_rom(cart, &chr_rom, &chr_rom_size), false,
+                  "Could not locate CHR ROM");
+  return_value_if(prg_rom_size == 0 || prg_rom_size % BUS_PAGE_SIZE != 0, false,
+                  "Invalid PRG ROM size: %zu", prg_rom_size);
+  return_value_if(chr_rom_size % PPU_CHR_PAGE_SIZE != 0, false, "Invalid CHR ROM size: %zu",
+                  chr_rom_size);
+
+  memset(&mapper->state, 0, sizeof(mapper->state));
+  mapper->info = info;
+  mapper->prg_rom = prg_rom;
+  mapper->prg_rom_size = prg_rom_size;
+  mapper->chr_writable = chr_rom_size == 0;
+  mapper->chr = mapper->chr_writable ? mapper->state.chr_ram : chr_rom;
+  mapper->chr_size = mapper->chr_writable ? sizeof(mapper->state.chr_ram) : chr_rom_size;
+  mapper->hard_wired_mirroring = get_hard_wired_mirroring(cart);
+  mapper->cpu = cpu;
+  mapper->ppu = ppu;
+  mapper->scheduler = scheduler;
+
+  // every board gets PRG RAM, games that do not use it never touch $6000-$7FFF
+  bus_map_read_memory(&cpu->bus, PRG_RAM_START, PRG_RAM_END, mapper->state.prg_ram,
+                      sizeof(mapper->state.prg_ram));
+  bus_map_write_memory(&cpu->bus, PRG_RAM_START, PRG_RAM_END, mapper->state.prg_ram,
+                       sizeof(mapper->state.prg_ram));
+#ifdef NES_PROFILE
+  bus_map_write_handler(&cpu->bus, PRG_ROM_START, PRG_ROM_END, profiled_write, mapper);
+#else
+  bus_map_write_handler(&cpu->bus, PRG_ROM_START, PRG_ROM_END, info->write, mapper);
+#endif
+
+  ppu_set_chr(ppu, mapper->chr, mapper->chr_size, mapper->chr_writable);
+  ppu_set_mirroring(ppu, mapper->hard_wired_mirroring);
+  if (info->power_on) {
+    info->power_on(mapper);
+  }
+  mapper_update_banks(mapper);
+#ifdef NES_STATS
+  mapper->bank_switches = 0;  // the power on banks are not switches
+#endif
+
+  return true;
+}
+
+// Maps the banks the registers select again, needed after mapper.state was overwritten
+void mapper_update_banks(mapper_t *mapper) { mapper->info->update_banks(mapper); }
@@ -0,0 +1,93 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cpu.h"
+#include "load_rom.h"
+#include "ppu.h"
+#include "scheduler.h"
+
+static constexpr uint32_t MAPPER_PRG_RAM_SIZE = 8 * 1024;
+static constexpr uint32_t MAPPER_CHR_RAM_SIZE = 8 * 1024;
+
+typedef struct {
+  uint8_t shift;
+  uint8_t shift_count;
+  uint8_t control;
+  uint8_t chr_banks[2];
+  uint8_t prg_bank;
+  uint64_t last_write;  // CPU cycle of the last write, writes on consecutive cycles are ignored
+} mmc1_t;
+
+typedef struct {
+  uint8_t bank_select;
+  uint8_t banks[8];
+  bool horizontal;
+  uint8_t irq_latch;
+  uint8_t irq_counter;
+  bool irq_reload;
+  bool irq_enabled;
+  uint64_t a12_rises;  // ppu_a12_rises() the counter has been clocked up to
+} mmc3_t;
+
+// Everything the mapper needs to resume, kept free of pointers so that it can be copied as is
+typedef struct {
+  union {
+    mmc1_t mmc1;
+    mmc3_t mmc3;
+    uint8_t bank;  // UxROM and CNROM
+  };
+  uint8_t prg_ram[MAPPER_PRG_RAM_SIZE];
+  uint8_t chr_ram[MAPPER_CHR_RAM_SIZE];  // used by carts without CHR ROM
+} mapper_state_t;
+
+typedef struct mapper mapper_t;
+
+typedef struct {
+  uint16_t number;
+  const char *name;
+  void (*power_on)(mapper_t *mapper);                    // optional, sets up the registers
+  void (*write)(void *ctx, uint16_t addr, uint8_t val);  // $8000-$FFFF
+  void (*update_banks)(mapper_t *mapper);                // maps the banks the registers select
+} mapper_info_t;
+
+// The cartridge board. The banks it selects are resolved into pointers into the ROM once per
+// bank switch and handed to the CPU bus and the PPU, so that reads never go through the mapper.
+struct mapper {
+  mapper_state_t state;
+  const mapper_info_t *info;
+
+  const uint8_t *prg_rom;
+  size_t prg_rom_size;
+  const uint8_t *chr;  // CHR ROM, or state.chr_ram
+  size_t chr_size;
+  bool chr_writable;
+  mirroring_t hard_wired_mirroring;
+
+  cpu_t *cpu;
+  ppu_t *ppu;
+  scheduler_t *scheduler;
+#ifdef NES_STATS
+  uint64_t bank_switches;  // PRG or CHR banks mapped where another bank was, since power on
+#endif
+};
+
+[[nodiscard]] bool mapper_init(mapper_t *mapper, const cartridge_t *cart, cpu_t *cpu, ppu_t *ppu,
+                               scheduler_t *scheduler);
+void mapper_update_banks(mapper_t *mapper);
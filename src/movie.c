@@ -0,0 +1,144 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#include "movie.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include "utils.h"
+
+static constexpr size_t MAX_MOVIE_SIZE = 256 * 1024 * 1024;
+
+private
+char *next_line(char *line) {
+  char *end = strchr(line, '\n');
+  return end != nullptr ? end + 1 : nullptr;
+}
+
+private
+bool starts_with(const char *str, const char *prefix) {
+  return strncmp(str, prefix, strlen(prefix)) == 0;
+}
+
+private
+uint8_t parse_buttons(const char *field) {
+  uint8_t buttons = 0;
+
+  // "RLDUTSBA" from bit 7 down to bit 0
+  for (uint8_t i = 0; i < 8 && field[i] != '|' && field[i] != '\r' && field[i] != '\n' &&
+                      field[i] != '\0';
+       i++) {
+    if (field[i] != ' ' && field[i] != '.') {
+      buttons |= (uint8_t)(0x80 >> i);
+    }
+  }
+  return buttons;
+}
+
+[[nodiscard]] private
+bool parse_frame(const char *line, movie_frame_t *frame) {
+  const char *field = line + 1;
+  frame->commands = (uint8_t)strtoul(field, nullptr, 10);
+
+  for (uint8_t port = 0; port < 2; port++) {
+    field = strchr(field, '|');
+    if (field == nullptr) {
+      return false;
+    }
+    frame->buttons[port] = parse_buttons(++field);
+  }
+  return true;
+}
+
+// Checks the header lines that change how the input lines have to be read
+[[nodiscard]] private
+bool check_header_line(const char *line) {
+  return_value_if(starts_with(line, "binary 1"), false, "binary FM2 movies are not supported");
+
+  if (starts_with(line, "port0 ") || starts_with(line, "port1 ")) {
+    long device = strtol(line + strlen("port0 "), nullptr, 10);
+    return_value_if(device != 0 && device != 1, false,
+                    "only standard controllers are supported, not input device %ld", device);
+  }
+  return true;
+}
+
+bool movie_load(arena_t *arena, movie_t *movie, const char *file_path) {
+  return_value_if(file_path == nullptr, false, ERR_NULL_FILEPATH);
+
+  FILE *movie_filep __attribute__((cleanup(cleanup_file))) = fopen(file_path, "rb");
+  return_value_if(movie_filep == nullptr, false, "cannot open file: %s", file_path);
+
+  struct stat st;
+  return_value_if(fstat(fileno(movie_filep), &st) != 0, false, "cannot stat file: %s", file_path);
+  return_value_if(st.st_size > (off_t)MAX_MOVIE_SIZE, false, "movie is too large: %s", file_path);
+
+  size_t size = (size_t)st.st_size;
+  char *text = new (arena, char, size + 1, NOZERO);
+  return_value_if(text == nullptr, false, "out of memory");
+  return_value_if(fread(text, 1, size, movie_filep) != size, false, "cannot read file: %s",
+                  file_path);
+  text[size] = '\0';
+
+  size_t frame_count = 0;
+  for (char *line = text; line != nullptr; line = next_line(line)) {
+    frame_count += *line == '|';
+  }
+
+  movie->frames = new (arena, movie_frame_t, frame_count);
+  return_value_if(movie->frames == nullptr && frame_count > 0, false, "out of memory");
+  movie->frame_count = frame_count;
+
+  size_t frame = 0;
+  for (char *line = text; line != nullptr; line = next_line(line)) {
+    if (*line == '|') {
+      return_value_if(!parse_frame(line, &movie->frames[frame++]), false,
+                      "malformed input line %zu in %s", frame, file_path);
+    } else if (!check_header_line(line)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Sets the buttons of `frame` and runs it, frames past the end of the movie run without input. A
+// power cycle is replayed as a reset, the memory of the console is not cleared.
+void movie_run_frame(nes_t *nes, const movie_t *movie, size_t frame) {
+  movie_frame_t input = frame < movie->frame_count ? movie->frames[frame] : (movie_frame_t){};
+
+  if (input.commands & (MOVIE_COMMAND_RESET | MOVIE_COMMAND_POWER)) {
+    nes_reset(nes);
+  }
+
+  nes->controllers.buttons[0] = input.buttons[0];
+  nes->controllers.buttons[1] = input.buttons[1];
+  nes_run_frame(nes);
+}
+
+// Runs the first `frame_count` frames of `movie`. With `verify` no pixels or samples are produced
+// until the last frame, which is rendered so that its framebuffer can still be hashed.
+void movie_run(nes_t *nes, const movie_t *movie, size_t frame_count, bool verify) {
+  nes_set_skip_output(nes, verify);
+  for (size_t frame = 0; frame < frame_count; frame++) {
+    // every scanline is drawn again in a frame, rendering the last one is enough to hash it
+    if (frame + 1 == frame_count) {
+      nes_set_skip_output(nes, false);
+    }
+    movie_run_frame(nes, movie, frame);
+  }
+}
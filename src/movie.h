@@ -0,0 +1,46 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "alloc.h"
+#include "nes.h"
+
+// Input movies in the text FM2 format of FCEUX, https://fceux.com/web/help/fm2.html: a header of
+// "key value" lines followed by one "|commands|port 0|port 1|port 2|" line per frame, the buttons
+// of a port written as "RLDUTSBA" with a space or a dot for the ones not held down. Only standard
+// controllers are supported.
+
+typedef enum {
+  MOVIE_COMMAND_RESET = 1 << 0,
+  MOVIE_COMMAND_POWER = 1 << 1,
+} movie_command_t;
+
+typedef struct {
+  uint8_t buttons[2];  // button_t bitmasks of both ports
+  uint8_t commands;    // movie_command_t bitmask, carried out before the frame runs
+} movie_frame_t;
+
+typedef struct {
+  movie_frame_t *frames;
+  size_t frame_count;
+} movie_t;
+
+[[nodiscard]] bool movie_load(arena_t *arena, movie_t *movie, const char *file_path);
+void movie_run_frame(nes_t *nes, const movie_t *movie, size_t frame);
+void movie_run(nes_t *nes, const movie_t *movie, size_t frame_count, bool verify);
@@ -0,0 +1,232 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#include "nes.h"
+
+#include "utils.h"
+
+static constexpr uint16_t RESET_VECTOR = 0xFFFC;
+static constexpr uint16_t IO_REGISTERS_START = 0x4000;
+static constexpr uint16_t IO_REGISTERS_END = 0x40FF;
+static constexpr uint16_t APU_STATUS = 0x4015;
+static constexpr uint16_t OAM_DMA = 0x4014;
+static constexpr uint16_t CONTROLLER_1 = 0x4016;
+static constexpr uint16_t CONTROLLER_2 = 0x4017;  // writes go to the APU frame counter
+static constexpr uint64_t OAM_DMA_CYCLES = 513;
+
+// A register write can schedule an event that is due before the deadline the CPU is running to,
+// e.g. an MMC3 IRQ or a DMC fetch. Stop at the first instruction boundary at or after it,
+// tools/irq_timing_check checks this with an MMC3 IRQ enabled in the middle of a scanline.
+private
+void on_earlier_event(void *ctx, uint64_t when) {
+  nes_t *nes = ctx;
+  uint64_t divider = nes->master_clocks_per_cpu_cycle;
+  cpu_lower_deadline(&nes->cpu, (when + divider - 1) / divider);
+}
+
+private
+uint8_t read_io_register(void *ctx, uint16_t addr) {
+  nes_t *nes = ctx;
+
+  if (addr == APU_STATUS) {
+    return apu_read_status(&nes->apu);
+  }
+  if (addr == CONTROLLER_1 || addr == CONTROLLER_2) {
+    // the upper bits are not driven by the controller port
+    return (nes->cpu.bus.open_bus & 0xE0) |
+           controllers_read(&nes->controllers, (uint8_t)(addr - CONTROLLER_1));
+  }
+  return nes->cpu.bus.open_bus;
+}
+
+// $4014 copies a page of CPU memory into OAM, halting the CPU for 513 cycles plus one more if
+// it was started on an odd cycle
+private
+void write_io_register(void *ctx, uint16_t addr, uint8_t val) {
+  nes_t *nes = ctx;
+
+  if (addr == OAM_DMA) {
+    uint8_t page[256];
+    for (uint16_t i = 0; i < 256; i++) {
+      page[i] = bus_read(&nes->cpu.bus, (uint16_t)((val << 8) | i));
+    }
+    ppu_write_oam_dma(&nes->ppu, page);
+    nes->cpu.cycles += OAM_DMA_CYCLES + (nes->cpu.cycles & 1);
+  } else if (addr == CONTROLLER_1) {
+    controllers_write(&nes->controllers, val);
+  } else {
+    apu_write_register(&nes->apu, addr, val);
+  }
+}
+
+void nes_power_on(nes_t *nes) {
+  cpu_power_on(&nes->cpu);
+  nes->cart = nullptr;
+  nes->controllers = (controllers_t){};
+  nes->master_clocks_per_cpu_cycle = NTSC_MASTER_CLOCKS_PER_CPU_CYCLE;
+  nes->master_clocks_per_ppu_dot = NTSC_MASTER_CLOCKS_PER_PPU_DOT;
+
+  scheduler_init(&nes->scheduler);
+  scheduler_set_earlier_event_handler(&nes->scheduler, on_earlier_event, nes);
+
+  ppu_power_on(&nes->ppu, &nes->cpu, &nes->scheduler);
+  apu_power_on(&nes->apu, &nes->cpu, &nes->scheduler);
+  bus_map_read_handler(&nes->cpu.bus, IO_REGISTERS_START, IO_REGISTERS_END, read_io_register, nes);
+  bus_map_write_handler(&nes->cpu.bus, IO_REGISTERS_START, IO_REGISTERS_END, write_io_register,
+                        nes);
+}
+
+private
+void set_timing(nes_t *nes, const cartridge_t *cart) {
+  cpu_ppu_timing_t timing = TIMING_NTSC;
+
+  if (cart->format_type == FORMAT_TYPE_INES2) {
+    timing = cart->ines2_header.cpu_ppu_timing;
+  } else if (cart->ines_header.tv_system == TV_SYSTEM_PAL) {
+    timing = TIMING_PAL;
+  }
+
+  switch (timing) {
+    case TIMING_PAL:
+      nes->master_clocks_per_cpu_cycle = PAL_MASTER_CLOCKS_PER_CPU_CYCLE;
+      nes->master_clocks_per_ppu_dot = PAL_MASTER_CLOCKS_PER_PPU_DOT;
+      break;
+    case TIMING_DENDY:
+      nes->master_clocks_per_cpu_cycle = DENDY_MASTER_CLOCKS_PER_CPU_CYCLE;
+      nes->master_clocks_per_ppu_dot = DENDY_MASTER_CLOCKS_PER_PPU_DOT;
+      break;
+    default:
+      nes->master_clocks_per_cpu_cycle = NTSC_MASTER_CLOCKS_PER_CPU_CYCLE;
+      nes->master_clocks_per_ppu_dot = NTSC_MASTER_CLOCKS_PER_PPU_DOT;
+  }
+
+  ppu_set_timing(&nes->ppu, timing);
+  apu_set_timing(&nes->apu, timing);
+}
+
+bool nes_insert_cartridge(nes_t *nes, cartridge_t *cart) {
+  set_timing(nes, cart);
+  return_value_if(!mapper_init(&nes->mapper, cart, &nes->cpu, &nes->ppu, &nes->scheduler), false,
+                  "Could not set up the cartridge board");
+  nes->cart = cart;
+
+  return true;
+}
+
+void nes_reset(nes_t *nes) {
+  // the reset button does not stop the master clock, keep it running so that the pending events
+  // stay valid
+  uint64_t cycles = nes->cpu.cycles;
+  cpu_reset(&nes->cpu);
+  nes->cpu.cycles = cycles;
+  ppu_reset(&nes->ppu);
+  apu_reset(&nes->apu);
+
+  uint8_t lo = bus_read(&nes->cpu.bus, RESET_VECTOR);
+  uint8_t hi = bus_read(&nes->cpu.bus, RESET_VECTOR + 1);
+  nes->cpu.pc = (uint16_t)(hi << 8) | lo;
+}
+
+// Runs the CPU up to the next pending event, lets the scheduler fire everything that is due and
+// repeats. The CPU can only stop at instruction boundaries, so it may overshoot `master_clock` by
+// a few cycles, the next call picks up from there.
+void nes_run_until(nes_t *nes, uint64_t master_clock) {
+  uint64_t divider = nes->master_clocks_per_cpu_cycle;
+
+  while (nes_now(nes) < master_clock) {
+    uint64_t next_event = scheduler_next_event(&nes->scheduler);
+    uint64_t deadline = next_event < master_clock ? next_event : master_clock;
+
+    cpu_run_until(&nes->cpu, (deadline + divider - 1) / divider);
+    scheduler_run_due(&nes->scheduler, nes_now(nes));
+  }
+}
+
+// Runs until the PPU enters vertical blank, at which point ppu.framebuffer holds a whole frame and
+// apu.samples the audio up to that point
+void nes_run_frame(nes_t *nes) {
+  uint64_t frame = nes->ppu.state.frame;
+
+  while (nes->ppu.state.frame == frame) {
+    uint64_t next_event = scheduler_next_event(&nes->scheduler);
+
+    if (next_event <= nes_now(nes)) {
+      scheduler_run_due(&nes->scheduler, nes_now(nes));
+    } else {
+      nes_run_until(nes, next_event);
+    }
+  }
+
+  apu_end_frame(&nes->apu, nes->cpu.cycles);
+}
+
+#ifdef NES_STATS
+void nes_get_stats(const nes_t *nes, nes_stats_t *stats) {
+  *stats = (nes_stats_t){.cpu = nes->cpu.stats, .bank_switches = nes->mapper.bank_switches};
+  for (int op = 0; op < 256; op++) {
+    stats->instructions += stats->cpu.opcodes[op];
+  }
+}
+
+void nes_reset_stats(nes_t *nes) {
+  nes->cpu.stats = (cpu_stats_t){};
+  nes->mapper.bank_switches = 0;
+}
+
+// Prints the totals and the opcodes executed the most
+void nes_print_stats(const nes_stats_t *stats, FILE *out) {
+  static constexpr int TOP_OPCODES = 16;
+  double instructions = stats->instructions ? (double)stats->instructions : 1.0;
+
+  fprintf(out, "instructions    %12llu\n", (unsigned long long)stats->instructions);
+  fprintf(out, "page crossings  %12llu  %.2f%% of instructions\n",
+          (unsigned long long)stats->cpu.page_crossings,
+          100.0 * (double)stats->cpu.page_crossings / instructions);
+  fprintf(out, "dummy reads     %12llu\n", (unsigned long long)stats->cpu.dummy_reads);
+  fprintf(out, "dummy writes    %12llu\n", (unsigned long long)stats->cpu.dummy_writes);
+  fprintf(out, "NMIs            %12llu\n", (unsigned long long)stats->cpu.nmis);
+  fprintf(out, "IRQs            %12llu\n", (unsigned long long)stats->cpu.irqs);
+  fprintf(out, "bank switches   %12llu\n", (unsigned long long)stats->bank_switches);
+
+  // a selection of the largest counts, the table is small enough to scan once per line
+  bool printed[256] = {};
+  for (int line = 0; line < TOP_OPCODES; line++) {
+    int top = -1;
+    for (int op = 0; op < 256; op++) {
+      if (!printed[op] && stats->cpu.opcodes[op] > 0 &&
+          (top < 0 || stats->cpu.opcodes[op] > stats->cpu.opcodes[top])) {
+        top = op;
+      }
+    }
+    if (top < 0) {
+      break;
+    }
+
+    printed[top] = true;
+    fprintf(out, "  $%02X %s %-11s %12llu  %5.2f%%\n", top, cpu_opcode_name((uint8_t)top),
+            cpu_addressing_mode_name(cpu_addressing_mode((uint8_t)top)),
+            (unsigned long long)stats->cpu.opcodes[top],
+            100.0 * (double)stats->cpu.opcodes[top] / instructions);
+  }
+}
+#endif
+
+// Stops producing pixels and samples, for runs that only look at RAM. Everything the CPU can
+// observe stays the same: sprite 0 hits are still found and the DMC still reads memory and raises
+// IRQs.
+void nes_set_skip_output(nes_t *nes, bool skip) {
+  ppu_set_skip_pixels(&nes->ppu, skip);
+  apu_set_skip_audio(&nes->apu, skip);
+}
@@ -0,0 +1,64 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#pragma once
+
+#include <stdio.h>
+
+#include "apu.h"
+#include "controller.h"
+#include "cpu.h"
+#include "load_rom.h"
+#include "mapper.h"
+#include "ppu.h"
+#include "scheduler.h"
+
+// The whole console, it owns every component and wires them to the CPU bus. The CPU drives the
+// master clock: the current time is always cpu.cycles * master_clocks_per_cpu_cycle.
+typedef struct {
+  cpu_t cpu;
+  ppu_t ppu;
+  apu_t apu;
+  controllers_t controllers;
+  scheduler_t scheduler;
+  uint64_t master_clocks_per_cpu_cycle;
+  uint64_t master_clocks_per_ppu_dot;
+  mapper_t mapper;
+  cartridge_t *cart;
+} nes_t;
+
+void nes_power_on(nes_t *nes);
+[[nodiscard]] bool nes_insert_cartridge(nes_t *nes, cartridge_t *cart);
+void nes_reset(nes_t *nes);
+void nes_run_until(nes_t *nes, uint64_t master_clock);
+void nes_run_frame(nes_t *nes);
+void nes_set_skip_output(nes_t *nes, bool skip);
+
+#ifdef NES_STATS
+typedef struct {
+  cpu_stats_t cpu;
+  uint64_t instructions;  // all of cpu.opcodes
+  uint64_t bank_switches;
+} nes_stats_t;
+
+// The counters since power on or the last nes_reset_stats(), build with -DNES_STATS
+void nes_get_stats(const nes_t *nes, nes_stats_t *stats);
+void nes_reset_stats(nes_t *nes);
+void nes_print_stats(const nes_stats_t *stats, FILE *out);
+#endif
+
+static inline uint64_t nes_now(const nes_t *nes) {
+  return nes->cpu.cycles * nes->master_clocks_per_cpu_cycle;
+}
@@ -0,0 +1,714 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#include "ppu.h"
+
+#include "profile.h"
+#include "utils.h"
+
+// The PPU is not stepped dot by dot. A scanline is rendered in one go, a tile at a time, when its
+// EVENT_PPU_SCANLINE fires at dot 340. A register access in the middle of a scanline first
+// renders the pixels up to the current dot with the old register values, so raster effects
+// (scroll splits, pattern table switches, sprite 0 polling) still land on the right pixel.
+
+static constexpr uint16_t PPU_REGISTERS_START = 0x2000;
+static constexpr uint16_t PPU_REGISTERS_END = 0x3FFF;
+
+static constexpr uint16_t NTSC_SCANLINES_PER_FRAME = 262;
+static constexpr uint16_t PAL_SCANLINES_PER_FRAME = 312;
+static constexpr uint16_t NTSC_VBLANK_SCANLINE = 241;
+static constexpr uint16_t DENDY_VBLANK_SCANLINE = 291;
+static constexpr uint16_t A12_RISE_DOT = 260;
+
+static constexpr uint8_t CTRL_INCREMENT_32 = 0x04;
+static constexpr uint8_t CTRL_SPRITE_TABLE = 0x08;
+static constexpr uint8_t CTRL_BACKGROUND_TABLE = 0x10;
+static constexpr uint8_t CTRL_SPRITE_8X16 = 0x20;
+static constexpr uint8_t CTRL_NMI_ENABLE = 0x80;
+
+static constexpr uint8_t MASK_GREYSCALE = 0x01;
+static constexpr uint8_t MASK_BACKGROUND_LEFT = 0x02;
+static constexpr uint8_t MASK_SPRITES_LEFT = 0x04;
+static constexpr uint8_t MASK_BACKGROUND = 0x08;
+static constexpr uint8_t MASK_SPRITES = 0x10;
+static constexpr uint8_t MASK_EMPHASIS = 0xE0;
+
+static constexpr uint8_t STATUS_SPRITE_OVERFLOW = 0x20;
+static constexpr uint8_t STATUS_SPRITE_ZERO_HIT = 0x40;
+static constexpr uint8_t STATUS_VBLANK = 0x80;
+
+// sprite_line entries: bits 0-1 color, bits 2-3 palette, 0 is a transparent pixel
+static constexpr uint8_t SPRITE_BEHIND_BACKGROUND = 0x10;
+static constexpr uint8_t SPRITE_ZERO = 0x20;
+
+static constexpr uint8_t OAM_ATTRIBUTE_FLIP_V = 0x80;
+static constexpr uint8_t OAM_ATTRIBUTE_FLIP_H = 0x40;
+static constexpr uint8_t OAM_ATTRIBUTE_PRIORITY = 0x20;
+
+static constexpr uint8_t SPRITES_PER_SCANLINE = 8;
+
+// read when no cartridge is inserted, writes to it are dropped as chr_writable is false
+static uint8_t empty_chr[PPU_CHR_PAGE_SIZE];
+
+private
+bool rendering_enabled(const ppu_t *ppu) {
+  return (ppu->state.mask & (MASK_BACKGROUND | MASK_SPRITES)) != 0;
+}
+
+private
+uint16_t prerender_scanline(const ppu_t *ppu) { return ppu->scanlines_per_frame - 1; }
+
+private
+uint64_t scanline_end(const ppu_t *ppu) {
+  const ppu_state_t *state = &ppu->state;
+  uint64_t dots = PPU_DOTS_PER_SCANLINE;
+
+  // NTSC skips the last dot of the pre-render scanline on odd frames when rendering
+  if (state->odd_frame && ppu->scanlines_per_frame == NTSC_SCANLINES_PER_FRAME &&
+      state->scanline == prerender_scanline(ppu) && rendering_enabled(ppu)) {
+    dots--;
+  }
+
+  return state->scanline_start + dots * ppu->master_clocks_per_dot;
+}
+
+private
+uint8_t read_chr(const ppu_t *ppu, uint16_t addr) {
+  return ppu->chr_pages[addr >> 10][addr & (PPU_CHR_PAGE_SIZE - 1)];
+}
+
+// The 8 pixels of the tile row at `addr`, see chr_decode.h
+private
+const uint8_t *decoded_row(const ppu_t *ppu, uint16_t addr) {
+  return (const uint8_t *)&ppu->chr_decoded[addr >> 10][((addr & 0x03F0) >> 1) | (addr & 0x07)];
+}
+
+private
+void refresh_chr(ppu_t *ppu) {
+  for (uint8_t i = 0; i < PPU_CHR_PAGE_COUNT; i++) {
+    if (ppu->chr_dirty[i]) {
+      chr_decode_tiles(ppu->chr_decoded[i], ppu->chr_pages[i], PPU_CHR_PAGE_SIZE / CHR_TILE_SIZE);
+      ppu->chr_dirty[i] = false;
+    }
+  }
+}
+
+// $3F10/$3F14/$3F18/$3F1C are mirrors of $3F00/$3F04/$3F08/$3F0C
+private
+uint8_t palette_index(uint16_t addr) {
+  uint8_t index = addr & 0x1F;
+  return (index & 0x13) == 0x10 ? index & 0x0F : index;
+}
+
+private
+uint8_t read_vram(const ppu_t *ppu, uint16_t addr) {
+  addr &= 0x3FFF;
+
+  if (addr < 0x2000) {
+    return read_chr(ppu, addr);
+  }
+  if (addr < 0x3F00) {
+    return ppu->nametables[(addr >> 10) & 0x03][addr & (PPU_NAMETABLE_SIZE - 1)];
+  }
+  return ppu->state.palette[palette_index(addr)];
+}
+
+private
+void write_vram(ppu_t *ppu, uint16_t addr, uint8_t val) {
+  addr &= 0x3FFF;
+
+  if (addr < 0x2000) {
+    if (ppu->chr_writable) {
+      // writable pages all point into the mapper's CHR RAM
+      uint8_t *page = (uint8_t *)ppu->chr_pages[addr >> 10];
+      page[addr & (PPU_CHR_PAGE_SIZE - 1)] = val;
+
+      // the same 1KiB may be mapped more than once
+      for (uint8_t i = 0; i < PPU_CHR_PAGE_COUNT; i++) {
+        ppu->chr_dirty[i] |= ppu->chr_pages[i] == page;
+      }
+    }
+  } else if (addr < 0x3F00) {
+    ppu->nametables[(addr >> 10) & 0x03][addr & (PPU_NAMETABLE_SIZE - 1)] = val;
+  } else {
+    ppu->state.palette[palette_index(addr)] = get_lower_6_bits(val);
+  }
+}
+
+// Horizontal scroll of pixel 0 of the current scanline in [0, 512), as if the coarse x of v had
+// been incremented for every tile from the start of the scanline
+private
+int16_t scroll_x_of(uint16_t v, uint8_t fine_x) {
+  return (int16_t)(((v & 0x0400) >> 2) | ((v & 0x001F) << 3) | fine_x);
+}
+
+private
+void increment_y(ppu_state_t *state) {
+  if ((state->v & 0x7000) != 0x7000) {
+    state->v += 0x1000;
+    return;
+  }
+
+  state->v &= ~0x7000;
+  uint16_t coarse_y = (state->v & 0x03E0) >> 5;
+
+  if (coarse_y == 29) {
+    coarse_y = 0;
+    state->v ^= 0x0800;
+  } else if (coarse_y == 31) {
+    coarse_y = 0;
+  } else {
+    coarse_y++;
+  }
+
+  state->v = (uint16_t)((state->v & ~0x03E0) | (coarse_y << 5));
+}
+
+// Sprites are evaluated once per scanline, the first eight in OAM order that cover it are drawn
+// into sprite_line, earlier sprites win when they overlap
+private
+void evaluate_sprites(ppu_t *ppu) {
+  ppu_state_t *state = &ppu->state;
+  uint8_t height = (state->ctrl & CTRL_SPRITE_8X16) ? 16 : 8;
+  uint8_t found = 0;
+
+  memset(ppu->sprite_line, 0, sizeof(ppu->sprite_line));
+  state->sprites_evaluated = true;
+
+  for (uint16_t i = 0; i < 64; i++) {
+    const uint8_t *sprite = &state->oam[i * 4];
+
+    // OAM holds the y coordinate minus one
+    int row = (int)state->scanline - 1 - sprite[0];
+    if (row < 0 || row >= height) {
+      continue;
+    }
+    if (found == SPRITES_PER_SCANLINE) {
+      state->status |= STATUS_SPRITE_OVERFLOW;
+      break;
+    }
+    found++;
+
+    if (!(state->mask & MASK_SPRITES)) {
+      continue;
+    }
+
+    uint8_t tile = sprite[1];
+    uint8_t attributes = sprite[2];
+    if (attributes & OAM_ATTRIBUTE_FLIP_V) {
+      row = height - 1 - row;
+    }
+
+    uint16_t addr;
+    if (height == 16) {
+      tile = (uint8_t)((tile & 0xFE) + (row >> 3));
+      addr = (uint16_t)((get_0th_bit(sprite[1]) << 12) | (tile << 4) | (row & 7));
+    } else {
+      addr = (uint16_t)(((state->ctrl & CTRL_SPRITE_TABLE) << 9) | (tile << 4) | row);
+    }
+
+    const uint8_t *pixels = decoded_row(ppu, addr);
+    uint8_t flags = (uint8_t)(get_lower_2_bits(attributes) << 2);
+    flags |= (attributes & OAM_ATTRIBUTE_PRIORITY) ? SPRITE_BEHIND_BACKGROUND : 0;
+    flags |= i == 0 ? SPRITE_ZERO : 0;
+
+    for (uint8_t column = 0; column < 8 && sprite[3] + column < PPU_SCREEN_WIDTH; column++) {
+      uint8_t color = pixels[(attributes & OAM_ATTRIBUTE_FLIP_H) ? 7 - column : column];
+      uint8_t *pixel = &ppu->sprite_line[sprite[3] + column];
+
+      if (color != 0 && *pixel == 0) {
+        *pixel = flags | color;
+      }
+    }
+  }
+}
+
+// Whether sprite 0 hit can still be set on the current scanline, the only effect of the rendered
+// pixels the CPU can see
+private
+bool sprite_zero_can_hit(const ppu_t *ppu) {
+  const ppu_state_t *state = &ppu->state;
+  uint8_t height = (state->ctrl & CTRL_SPRITE_8X16) ? 16 : 8;
+  int row = (int)state->scanline - 1 - state->oam[0];
+
+  return !(state->status & STATUS_SPRITE_ZERO_HIT) && (state->mask & MASK_SPRITES) &&
+         (state->mask & MASK_BACKGROUND) && row >= 0 && row < height;
+}
+
+// Fills bg[x, x_end) with palette RAM indices of the background, 0 for transparent pixels. The
+// nametable, attribute and pattern bytes are fetched once per tile, and every tile is stored as a
+// whole, so `bg` needs 8 bytes of slack on both sides.
+private
+void fetch_background(const ppu_t *ppu, uint8_t *bg, uint16_t x, uint16_t x_end) {
+  const ppu_state_t *state = &ppu->state;
+
+  if (!(state->mask & MASK_BACKGROUND)) {
+    memset(bg + x, 0, x_end - x);
+    return;
+  }
+
+  uint16_t fine_y = (state->v >> 12) & 0x07;
+  uint16_t coarse_y = (state->v >> 5) & 0x1F;
+  uint16_t nametable_y = (state->v >> 10) & 0x02;
+  uint16_t table = (uint16_t)((state->ctrl & CTRL_BACKGROUND_TABLE) << 8);
+
+  while (x < x_end) {
+    uint16_t scroll_x = (uint16_t)(state->line_scroll_x + x) & 0x01FF;
+    uint16_t coarse_x = (scroll_x >> 3) & 0x1F;
+    const uint8_t *nametable = ppu->nametables[nametable_y | (scroll_x >> 8)];
+
+    uint8_t tile = nametable[coarse_y * 32 + coarse_x];
+    uint8_t attribute = nametable[0x03C0 + (coarse_y >> 2) * 8 + (coarse_x >> 2)];
+    uint8_t palette = (attribute >> (((coarse_y & 0x02) << 1) | (coarse_x & 0x02))) & 0x03;
+    uint64_t pixels;
+    memcpy(&pixels, decoded_row(ppu, table | (uint16_t)(tile << 4) | fine_y), sizeof(pixels));
+
+    // add the palette to the opaque pixels, every byte is at most 3 so nothing carries over
+    uint64_t opaque = (pixels | (pixels >> 1)) & 0x0101010101010101;
+    pixels |= opaque * (uint64_t)(palette << 2);
+
+    uint8_t fine_x = scroll_x & 0x07;
+    memcpy(bg + x - fine_x, &pixels, sizeof(pixels));
+    x = (uint16_t)(x + 8 - fine_x);
+  }
+}
+
+// Renders the current scanline from rendered_x up to, but not including, x_end
+private
+void render_pixels(ppu_t *ppu, uint16_t x_end) {
+  ppu_state_t *state = &ppu->state;
+  uint16_t x = state->rendered_x;
+  uint8_t *out = ppu->framebuffer[state->scanline];
+  uint8_t greyscale = (state->mask & MASK_GREYSCALE) ? 0x30 : 0x3F;
+
+  if (x >= x_end) {
+    return;
+  }
+  state->rendered_x = x_end;
+
+  if (!rendering_enabled(ppu)) {
+    // with rendering off the backdrop is shown, unless v points into palette RAM
+    uint8_t index = (state->v & 0x3F00) == 0x3F00 ? palette_index(state->v) : 0;
+    if (!ppu->skip_pixels) {
+      memset(out + x, state->palette[index] & greyscale, x_end - x);
+    }
+    return;
+  }
+
+  refresh_chr(ppu);
+  if (!state->sprites_evaluated) {
+    evaluate_sprites(ppu);
+  }
+  if (ppu->skip_pixels && !sprite_zero_can_hit(ppu)) {
+    return;
+  }
+
+  uint8_t bg_buffer[8 + PPU_SCREEN_WIDTH + 8];
+  uint8_t *bg = bg_buffer + 8;
+  fetch_background(ppu, bg, x, x_end);
+
+  for (; x < x_end; x++) {
+    uint8_t background = bg[x];
+    uint8_t sprite = ppu->sprite_line[x];
+
+    if (x < 8) {
+      background = (state->mask & MASK_BACKGROUND_LEFT) ? background : 0;
+      sprite = (state->mask & MASK_SPRITES_LEFT) ? sprite : 0;
+    }
+
+    if (sprite && background && (sprite & SPRITE_ZERO) && x != PPU_SCREEN_WIDTH - 1) {
+      state->status |= STATUS_SPRITE_ZERO_HIT;
+    }
+
+    uint8_t index = background;
+    if (sprite && (!background || !(sprite & SPRITE_BEHIND_BACKGROUND))) {
+      index = 0x10 | get_lower_4_bits(sprite);
+    }
+
+    out[x] = state->palette[index] & greyscale;
+  }
+}
+
+// Does everything the current scanline does before `dot`
+private
+void run_scanline_to(ppu_t *ppu, uint16_t dot) {
+  ppu_state_t *state = &ppu->state;
+  bool prerender = state->scanline == prerender_scanline(ppu);
+
+  if (state->scanline >= PPU_SCREEN_HEIGHT && !prerender) {
+    return;
+  }
+
+  // pixel x is output at dot x + 1
+  if (!prerender && dot > 1) {
+    render_pixels(ppu, dot - 1 < PPU_SCREEN_WIDTH ? dot - 1 : PPU_SCREEN_WIDTH);
+  }
+
+  // dot 256 moves v down a row, dot 257 reloads its horizontal position from t
+  if (dot > 257 && !state->line_v_updated) {
+    state->line_v_updated = true;
+    if (rendering_enabled(ppu)) {
+      increment_y(state);
+      state->v = (state->v & ~0x041F) | (state->t & 0x041F);
+    }
+  }
+
+  // dots 280-304 of the pre-render scanline reload the vertical position from t
+  if (prerender && dot > 304 && !state->prerender_copied) {
+    state->prerender_copied = true;
+    if (rendering_enabled(ppu)) {
+      state->v = (state->v & ~0x7BE0) | (state->t & 0x7BE0);
+    }
+  }
+
+  // the sprite pattern fetches starting at dot 257 raise A12, counted once they are over
+  if (dot > A12_RISE_DOT && !state->a12_counted) {
+    state->a12_counted = true;
+    if (rendering_enabled(ppu)) {
+      state->a12_rises++;
+    }
+  }
+}
+
+private
+void start_scanline(ppu_t *ppu) {
+  ppu_state_t *state = &ppu->state;
+
+  state->rendered_x = 0;
+  state->line_scroll_x = scroll_x_of(state->v, state->x);
+  state->sprites_evaluated = false;
+  state->line_v_updated = false;
+  state->prerender_copied = false;
+  state->a12_counted = false;
+
+  if (state->scanline < PPU_SCREEN_HEIGHT) {
+    ppu->emphasis[state->scanline] = state->mask & MASK_EMPHASIS;
+  } else if (state->scanline == ppu->vblank_scanline) {
+    state->status |= STATUS_VBLANK;
+    state->frame++;
+    if (state->ctrl & CTRL_NMI_ENABLE) {
+      cpu_trigger_nmi(ppu->cpu);
+    }
+  } else if (state->scanline == prerender_scanline(ppu)) {
+    state->status &= ~(STATUS_VBLANK | STATUS_SPRITE_ZERO_HIT | STATUS_SPRITE_OVERFLOW);
+  }
+}
+
+private
+void finish_scanline(ppu_t *ppu) {
+  ppu_state_t *state = &ppu->state;
+
+  run_scanline_to(ppu, PPU_DOTS_PER_SCANLINE);
+  state->scanline_start = scanline_end(ppu);
+
+  if (state->scanline == prerender_scanline(ppu)) {
+    state->scanline = 0;
+    state->odd_frame = !state->odd_frame;
+  } else {
+    state->scanline++;
+  }
+
+  start_scanline(ppu);
+}
+
+// Brings the PPU up to master clock `now`, finishing any scanline that ended before it
+void ppu_catch_up(ppu_t *ppu, uint64_t now) {
+  ppu_state_t *state = &ppu->state;
+  bool finished = false;
+  profile_component_t previous = profile_enter(PROFILE_PPU);
+
+  while (now >= scanline_end(ppu)) {
+    finish_scanline(ppu);
+    finished = true;
+  }
+
+  if (finished) {
+    scheduler_schedule(ppu->scheduler, EVENT_PPU_SCANLINE, scanline_end(ppu));
+  }
+
+  if (now > state->scanline_start) {
+    run_scanline_to(ppu, (uint16_t)((now - state->scanline_start) / ppu->master_clocks_per_dot));
+  }
+  profile_leave(previous);
+}
+
+private
+void on_scanline_end(void *ctx, uint64_t when) {
+  ppu_t *ppu = ctx;
+
+  ppu_catch_up(ppu, when);
+  // the scanline may have got a dot longer since this event was scheduled
+  scheduler_schedule(ppu->scheduler, EVENT_PPU_SCANLINE, scanline_end(ppu));
+}
+
+private
+void sync(ppu_t *ppu) {
+  ppu_catch_up(ppu, ppu->cpu->cycles * ppu->master_clocks_per_cpu_cycle);
+}
+
+private
+void increment_v(ppu_state_t *state) {
+  state->v = (state->v + ((state->ctrl & CTRL_INCREMENT_32) ? 32 : 1)) & 0x7FFF;
+}
+
+private
+uint8_t read_register(void *ctx, uint16_t addr) {
+  ppu_t *ppu = ctx;
+  ppu_state_t *state = &ppu->state;
+
+  sync(ppu);
+
+  switch (addr & 0x07) {
+    case 2:
+      state->io_latch = (state->status & 0xE0) | (state->io_latch & 0x1F);
+      state->status &= ~STATUS_VBLANK;
+      state->w = false;
+      break;
+    case 4:
+      state->io_latch = state->oam[state->oam_addr];
+      // the unimplemented bits of the attribute byte read back as 0
+      if ((state->oam_addr & 0x03) == 2) {
+        state->io_latch &= 0xE3;
+      }
+      break;
+    case 7:
+      // reads below the palette go through a buffer and return the previous value
+      if ((state->v & 0x3FFF) >= 0x3F00) {
+        state->io_latch = (state->io_latch & 0xC0) | read_vram(ppu, state->v);
+        state->read_buffer = read_vram(ppu, state->v - 0x1000);
+      } else {
+        state->io_latch = state->read_buffer;
+        state->read_buffer = read_vram(ppu, state->v);
+      }
+      increment_v(state);
+      break;
+    default:
+      break;
+  }
+
+  return state->io_latch;
+}
+
+private
+void write_register(void *ctx, uint16_t addr, uint8_t val) {
+  ppu_t *ppu = ctx;
+  ppu_state_t *state = &ppu->state;
+
+  sync(ppu);
+  state->io_latch = val;
+
+  switch (addr & 0x07) {
+    case 0:
+      // enabling NMIs during vertical blank raises one right away
+      if ((val & CTRL_NMI_ENABLE) && !(state->ctrl & CTRL_NMI_ENABLE) &&
+          (state->status & STATUS_VBLANK)) {
+        cpu_trigger_nmi(ppu->cpu);
+      }
+      state->ctrl = val;
+      state->t = (uint16_t)((state->t & ~0x0C00) | (get_lower_2_bits(val) << 10));
+      break;
+    case 1:
+      state->mask = val;
+      break;
+    case 3:
+      state->oam_addr = val;
+      break;
+    case 4:
+      state->oam[state->oam_addr++] = val;
+      break;
+    case 5:
+      if (!state->w) {
+        // fine x takes effect on the next pixel, coarse x only on the next scanline
+        state->line_scroll_x += (int16_t)((val & 0x07) - state->x);
+        state->x = val & 0x07;
+        state->t = (uint16_t)((state->t & ~0x001F) | (val >> 3));
+      } else {
+        state->t = (uint16_t)((state->t & ~0x73E0) | ((val & 0x07) << 12) | ((val & 0xF8) << 2));
+      }
+      state->w = !state->w;
+      break;
+    case 6:
+      if (!state->w) {
+        state->t = (uint16_t)((state->t & 0x00FF) | ((val & 0x3F) << 8));
+      } else {
+        state->t = (state->t & 0xFF00) | val;
+        state->v = state->t;
+        state->line_scroll_x = (int16_t)(scroll_x_of(state->v, state->x) - state->rendered_x);
+      }
+      state->w = !state->w;
+      break;
+    case 7:
+      write_vram(ppu, state->v, val);
+      increment_v(state);
+      break;
+    default:
+      break;
+  }
+}
+
+void ppu_power_on(ppu_t *ppu, cpu_t *cpu, scheduler_t *scheduler) {
+  memset(&ppu->state, 0, sizeof(ppu->state));
+  memset(ppu->framebuffer, 0, sizeof(ppu->framebuffer));
+  memset(ppu->emphasis, 0, sizeof(ppu->emphasis));
+  ppu->skip_pixels = false;
+
+  ppu->cpu = cpu;
+  ppu->scheduler = scheduler;
+  bus_map_read_handler(&cpu->bus, PPU_REGISTERS_START, PPU_REGISTERS_END, read_register, ppu);
+  bus_map_write_handler(&cpu->bus, PPU_REGISTERS_START, PPU_REGISTERS_END, write_register, ppu);
+  scheduler_set_handler(scheduler, EVENT_PPU_SCANLINE, on_scanline_end, ppu);
+
+  // start on the pre-render scanline so that the first frame is a complete one
+  ppu_set_timing(ppu, TIMING_NTSC);
+  ppu_set_chr(ppu, empty_chr, sizeof(empty_chr), false);
+  ppu_set_mirroring(ppu, MIRRORING_HORIZONTAL);
+}
+
+// Like the reset button: the registers are cleared but the PPU keeps its place in the frame
+void ppu_reset(ppu_t *ppu) {
+  ppu_state_t *state = &ppu->state;
+
+  sync(ppu);
+  state->ctrl = 0;
+  state->mask = 0;
+  state->w = false;
+  state->x = 0;
+  state->t = 0;
+  state->read_buffer = 0;
+}
+
+void ppu_set_timing(ppu_t *ppu, cpu_ppu_timing_t timing) {
+  ppu_state_t *state = &ppu->state;
+
+  switch (timing) {
+    case TIMING_PAL:
+      ppu->master_clocks_per_cpu_cycle = PAL_MASTER_CLOCKS_PER_CPU_CYCLE;
+      ppu->master_clocks_per_dot = PAL_MASTER_CLOCKS_PER_PPU_DOT;
+      ppu->scanlines_per_frame = PAL_SCANLINES_PER_FRAME;
+      ppu->vblank_scanline = NTSC_VBLANK_SCANLINE;
+      break;
+    case TIMING_DENDY:
+      ppu->master_clocks_per_cpu_cycle = DENDY_MASTER_CLOCKS_PER_CPU_CYCLE;
+      ppu->master_clocks_per_dot = DENDY_MASTER_CLOCKS_PER_PPU_DOT;
+      ppu->scanlines_per_frame = PAL_SCANLINES_PER_FRAME;
+      ppu->vblank_scanline = DENDY_VBLANK_SCANLINE;
+      break;
+    default:
+      ppu->master_clocks_per_cpu_cycle = NTSC_MASTER_CLOCKS_PER_CPU_CYCLE;
+      ppu->master_clocks_per_dot = NTSC_MASTER_CLOCKS_PER_PPU_DOT;
+      ppu->scanlines_per_frame = NTSC_SCANLINES_PER_FRAME;
+      ppu->vblank_scanline = NTSC_VBLANK_SCANLINE;
+  }
+
+  state->scanline = prerender_scanline(ppu);
+  state->scanline_start = ppu->cpu->cycles * ppu->master_clocks_per_cpu_cycle;
+  start_scanline(ppu);
+  scheduler_schedule(ppu->scheduler, EVENT_PPU_SCANLINE, scanline_end(ppu));
+}
+
+private
+void map_nametables(ppu_t *ppu) {
+  static constexpr uint8_t layouts[][4] = {
+      [MIRRORING_HORIZONTAL] = {0, 0, 1, 1},         [MIRRORING_VERTICAL] = {0, 1, 0, 1},
+      [MIRRORING_SINGLE_SCREEN_LOW] = {0, 0, 0, 0},  [MIRRORING_SINGLE_SCREEN_HIGH] = {1, 1, 1, 1},
+      [MIRRORING_FOUR_SCREEN] = {0, 1, 2, 3},
+  };
+
+  for (uint8_t i = 0; i < 4; i++) {
+    ppu->nametables[i] = ppu->state.vram + layouts[ppu->state.mirroring][i] * PPU_NAMETABLE_SIZE;
+  }
+}
+
+void ppu_set_mirroring(ppu_t *ppu, mirroring_t mirroring) {
+  sync(ppu);
+  ppu->state.mirroring = mirroring;
+  map_nametables(ppu);
+}
+
+// Rebuilds what is derived from `state` after it was overwritten as a whole, e.g. by loading a save
+// state. Does not catch up, and the CHR pages are left to the mapper.
+void ppu_state_changed(ppu_t *ppu) {
+  map_nametables(ppu);
+  for (uint8_t i = 0; i < PPU_CHR_PAGE_COUNT; i++) {
+    ppu->chr_dirty[i] = true;
+  }
+}
+
+// Maps `chr` over $0000-$1FFF, mirrored if it is smaller than 8KiB. `chr_size` has to be a
+// multiple of PPU_CHR_PAGE_SIZE.
+void ppu_set_chr(ppu_t *ppu, const uint8_t *chr, size_t chr_size, bool writable) {
+  for (uint8_t i = 0; i < PPU_CHR_PAGE_COUNT; i++) {
+    ppu_set_chr_page(ppu, i, chr + (i * PPU_CHR_PAGE_SIZE) % chr_size);
+    // the memory may have been rewritten behind the same pointer
+    ppu->chr_dirty[i] = true;
+  }
+  ppu->chr_writable = writable;
+}
+
+// Maps 1KiB of CHR at `chr` into $0000-$1FFF, `page` counts in 1KiB steps. Mapping the page that
+// is already there is free, so mappers can map all their banks on every bank switch.
+void ppu_set_chr_page(ppu_t *ppu, uint8_t page, const uint8_t *chr) {
+  if (ppu->chr_pages[page] == chr) {
+    return;
+  }
+
+  sync(ppu);
+  ppu->chr_pages[page] = chr;
+  ppu->chr_dirty[page] = true;
+}
+
+// While set the framebuffer is left alone, except for the scanlines sprite 0 may hit on
+void ppu_set_skip_pixels(ppu_t *ppu, bool skip) {
+  sync(ppu);
+  ppu->skip_pixels = skip;
+}
+
+// `page` is the 256 byte CPU page written to $4014, copied starting at OAMADDR
+void ppu_write_oam_dma(ppu_t *ppu, const uint8_t *page) {
+  ppu_state_t *state = &ppu->state;
+
+  sync(ppu);
+  for (uint16_t i = 0; i < 256; i++) {
+    state->oam[(uint8_t)(state->oam_addr + i)] = page[i];
+  }
+}
+
+// The number of A12 rises up to master clock `now`
+uint64_t ppu_a12_rises(ppu_t *ppu, uint64_t now) {
+  ppu_catch_up(ppu, now);
+  return ppu->state.a12_rises;
+}
+
+// Predicts the master clock at which a12_rises will have grown by `rises`, assuming rendering
+// stays enabled. The short pre-render scanline of odd frames is not taken into account, the
+// prediction can be a dot late.
+uint64_t ppu_a12_rise_time(const ppu_t *ppu, uint32_t rises) {
+  const ppu_state_t *state = &ppu->state;
+  uint64_t line_length = PPU_DOTS_PER_SCANLINE * ppu->master_clocks_per_dot;
+  uint16_t scanline = state->scanline;
+  uint64_t start = state->scanline_start;
+  bool counted = state->a12_counted;
+
+  for (;;) {
+    bool rendered = scanline < PPU_SCREEN_HEIGHT || scanline == prerender_scanline(ppu);
+    if (rendered && !counted && --rises == 0) {
+      return start + (A12_RISE_DOT + 1) * ppu->master_clocks_per_dot;
+    }
+
+    start += line_length;
+    scanline = scanline == prerender_scanline(ppu) ? 0 : scanline + 1;
+    counted = false;
+  }
+}
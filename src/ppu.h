@@ -0,0 +1,116 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#pragma once
+
+#include <stdint.h>
+
+#include "chr_decode.h"
+#include "cpu.h"
+#include "load_rom.h"
+#include "scheduler.h"
+
+static constexpr uint16_t PPU_SCREEN_WIDTH = 256;
+static constexpr uint16_t PPU_SCREEN_HEIGHT = 240;
+static constexpr uint16_t PPU_DOTS_PER_SCANLINE = 341;
+static constexpr uint16_t PPU_CHR_PAGE_SIZE = 1024;
+static constexpr uint16_t PPU_CHR_PAGE_COUNT = 8;
+static constexpr uint16_t PPU_NAMETABLE_SIZE = 1024;
+
+typedef enum {
+  MIRRORING_HORIZONTAL,
+  MIRRORING_VERTICAL,
+  MIRRORING_SINGLE_SCREEN_LOW,
+  MIRRORING_SINGLE_SCREEN_HIGH,
+  MIRRORING_FOUR_SCREEN
+} mirroring_t;
+
+// Everything the PPU needs to resume, kept free of pointers so that it can be copied as is
+typedef struct {
+  uint8_t ctrl;
+  uint8_t mask;
+  uint8_t status;
+  uint8_t oam_addr;
+  uint16_t v;  // current VRAM address, see https://www.nesdev.org/wiki/PPU_scrolling
+  uint16_t t;  // temporary VRAM address
+  uint8_t x;   // fine x scroll
+  bool w;      // first or second write toggle of $2005/$2006
+  uint8_t read_buffer;
+  uint8_t io_latch;  // returned for the write only registers
+  mirroring_t mirroring;
+
+  uint16_t scanline;
+  uint64_t scanline_start;  // master clock at dot 0 of `scanline`
+  uint64_t frame;           // incremented at the start of every vertical blank
+  bool odd_frame;
+
+  // progress of the scanline being rendered, register accesses in the middle of a scanline
+  // render it up to the current dot before they take effect
+  uint16_t rendered_x;
+  int16_t line_scroll_x;  // horizontal scroll at pixel 0, includes the nametable bit
+  bool sprites_evaluated;
+  bool line_v_updated;    // dot 256/257 updates of v are done
+  bool prerender_copied;  // dot 280-304 vertical copy of the pre-render scanline is done
+  bool a12_counted;       // the A12 rise of this scanline is counted in a12_rises
+
+  // Rising edges of PPU address line A12, one per rendered scanline when the background uses the
+  // pattern table at $0000 and sprites the one at $1000. MMC3 style scanline counters clock on
+  // them, mappers read this instead of being called on every scanline.
+  uint64_t a12_rises;
+
+  uint8_t oam[256];
+  uint8_t vram[4 * PPU_NAMETABLE_SIZE];  // 2KiB on the console, four screen carts add 2KiB
+  uint8_t palette[32];
+} ppu_state_t;
+
+typedef struct {
+  ppu_state_t state;
+
+  // pre-resolved views of the PPU address space, rebuilt by the mapper on bank switches
+  const uint8_t *chr_pages[PPU_CHR_PAGE_COUNT];  // only written through if chr_writable
+  bool chr_writable;
+  // chr_pages run through chr_decode_tiles(), a page marked dirty is decoded again before the
+  // next pixel is rendered
+  uint64_t chr_decoded[PPU_CHR_PAGE_COUNT][PPU_CHR_PAGE_SIZE / CHR_TILE_SIZE * CHR_TILE_ROWS];
+  bool chr_dirty[PPU_CHR_PAGE_COUNT];
+  uint8_t *nametables[4];
+
+  // sprites of the scanline being rendered, 0 means transparent, see evaluate_sprites()
+  uint8_t sprite_line[PPU_SCREEN_WIDTH];
+
+  uint8_t framebuffer[PPU_SCREEN_HEIGHT][PPU_SCREEN_WIDTH];  // 6 bit palette indices
+  uint8_t emphasis[PPU_SCREEN_HEIGHT];                      // PPUMASK bits 5-7 of every line
+  bool skip_pixels;  // only the scanlines sprite 0 can hit on are rendered
+
+  cpu_t *cpu;
+  scheduler_t *scheduler;
+  uint64_t master_clocks_per_cpu_cycle;
+  uint64_t master_clocks_per_dot;
+  uint16_t scanlines_per_frame;
+  uint16_t vblank_scanline;
+} ppu_t;
+
+void ppu_power_on(ppu_t *ppu, cpu_t *cpu, scheduler_t *scheduler);
+void ppu_reset(ppu_t *ppu);
+void ppu_set_timing(ppu_t *ppu, cpu_ppu_timing_t timing);
+void ppu_set_mirroring(ppu_t *ppu, mirroring_t mirroring);
+void ppu_state_changed(ppu_t *ppu);
+void ppu_set_skip_pixels(ppu_t *ppu, bool skip);
+void ppu_set_chr(ppu_t *ppu, const uint8_t *chr, size_t chr_size, bool writable);
+void ppu_set_chr_page(ppu_t *ppu, uint8_t page, const uint8_t *chr);
+void ppu_catch_up(ppu_t *ppu, uint64_t now);
+void ppu_write_oam_dma(ppu_t *ppu, const uint8_t *page);
+uint64_t ppu_a12_rises(ppu_t *ppu, uint64_t now);
+uint64_t ppu_a12_rise_time(const ppu_t *ppu, uint32_t rises);
@@ -0,0 +1,63 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#include "profile.h"
+
+#ifdef NES_PROFILE
+#include <time.h>
+
+#include "utils.h"
+
+typedef struct {
+  uint64_t ns[PROFILE_COMPONENT_COUNT];
+  profile_component_t current;
+  uint64_t since;  // when `current` started running
+} profile_t;
+
+static thread_local profile_t profile;
+
+private
+uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+// Charges the time since the last switch to the component that was running
+private
+void switch_to(profile_component_t component) {
+  uint64_t now = now_ns();
+  profile.ns[profile.current] += now - profile.since;
+  profile.current = component;
+  profile.since = now;
+}
+
+void profile_reset(void) { profile = (profile_t){.current = PROFILE_CPU, .since = now_ns()}; }
+
+void profile_read(uint64_t ns[PROFILE_COMPONENT_COUNT]) {
+  switch_to(profile.current);
+  for (int i = 0; i < PROFILE_COMPONENT_COUNT; i++) {
+    ns[i] = profile.ns[i];
+  }
+}
+
+profile_component_t profile_enter(profile_component_t component) {
+  profile_component_t previous = profile.current;
+  switch_to(component);
+  return previous;
+}
+
+void profile_leave(profile_component_t previous) { switch_to(previous); }
+#endif
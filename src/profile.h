@@ -0,0 +1,58 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#pragma once
+
+#include <stdint.h>
+
+// Splits the time spent emulating between the components, enabled at compile time with
+// -DNES_PROFILE. The components take turns on one thread: whatever catches a component up marks
+// it as running with profile_enter() and hands back to the one it interrupted with
+// profile_leave(). Time outside of any marked section, including the scheduler, is the CPU's.
+//
+// The totals are kept per thread, which is per console as long as a thread runs one console at a
+// time. Without NES_PROFILE every call compiles to nothing.
+
+typedef enum {
+  PROFILE_CPU,
+  PROFILE_PPU,
+  PROFILE_APU,
+  PROFILE_MAPPER,
+  PROFILE_COMPONENT_COUNT
+} profile_component_t;
+
+#ifdef NES_PROFILE
+// Zeroes the totals of this thread, the time from now on is the CPU's until a component enters
+void profile_reset(void);
+// Nanoseconds per component since profile_reset(), up to now
+void profile_read(uint64_t ns[PROFILE_COMPONENT_COUNT]);
+profile_component_t profile_enter(profile_component_t component);
+void profile_leave(profile_component_t previous);
+#else
+static inline void profile_reset(void) {}
+
+static inline void profile_read(uint64_t ns[PROFILE_COMPONENT_COUNT]) {
+  for (int i = 0; i < PROFILE_COMPONENT_COUNT; i++) {
+    ns[i] = 0;
+  }
+}
+
+static inline profile_component_t profile_enter(profile_component_t component) {
+  (void)component;
+  return PROFILE_CPU;
+}
+
+static inline void profile_leave(profile_component_t previous) { (void)previous; }
+#endif
@@ -0,0 +1,221 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#include "rewind.h"
+
+#include <string.h>
+
+#include "utils.h"
+
+// A run of differing bytes only ends at this many equal bytes, shorter gaps cost more as a token
+static constexpr size_t MIN_EQUAL_RUN = 4;
+// Neither varint of a token is longer than the run it counts, so a delta is at most twice as large
+// as a save state
+static constexpr size_t MAX_DELTA_SIZE = 2 * sizeof(savestate_t) + 16;
+
+bool rewind_init(arena_t *arena, rewind_t *rewind, size_t buffer_size, size_t max_frames) {
+  return_value_if(max_frames == 0, false, "Rewind history cannot be empty");
+  return_value_if(buffer_size > UINT32_MAX, false, "Rewind buffer cannot be larger than 4GiB");
+
+  rewind->current = new (arena, savestate_t);
+  rewind->next = new (arena, savestate_t);
+  rewind->encoded = new (arena, uint8_t, MAX_DELTA_SIZE, NOZERO);
+  rewind->buffer = new (arena, uint8_t, buffer_size, NOZERO);
+  rewind->entries = new (arena, rewind_entry_t, max_frames, NOZERO);
+  return_value_if(rewind->current == nullptr || rewind->next == nullptr ||
+                      rewind->encoded == nullptr || rewind->buffer == nullptr ||
+                      rewind->entries == nullptr,
+                  false, "Not enough memory for a %zu byte rewind buffer", buffer_size);
+
+  rewind->buffer_size = buffer_size;
+  rewind->entry_capacity = max_frames;
+  rewind_clear(rewind);
+
+  return true;
+}
+
+void rewind_clear(rewind_t *rewind) {
+  rewind->has_state = false;
+  rewind->buffer_used = 0;
+  rewind->first = 0;
+  rewind->count = 0;
+}
+
+private
+uint8_t *put_varint(uint8_t *out, size_t val) {
+  for (; val >= 0x80; val >>= 7) {
+    *out++ = (uint8_t)(val | 0x80);
+  }
+  *out++ = (uint8_t)val;
+  return out;
+}
+
+private
+size_t get_varint(const uint8_t **in) {
+  size_t val = 0;
+  uint8_t shift = 0;
+
+  for (;;) {
+    uint8_t byte = *(*in)++;
+    val |= (size_t)(byte & 0x7F) << shift;
+    if (byte < 0x80) {
+      return val;
+    }
+    shift += 7;
+  }
+}
+
+private
+uint64_t load_word(const uint8_t *p) {
+  uint64_t word;
+  memcpy(&word, p, sizeof(word));
+  return word;
+}
+
+// Encodes the XOR of `a` and `b` as tokens of a varint count of equal bytes, a varint count of
+// differing bytes and their XOR. Trailing equal bytes are left out.
+private
+size_t encode_delta(uint8_t *out, const uint8_t *a, const uint8_t *b, size_t size) {
+  uint8_t *start = out;
+  size_t pos = 0;
+
+  for (;;) {
+    size_t equal_end = pos;
+    while (equal_end + sizeof(uint64_t) <= size &&
+           load_word(a + equal_end) == load_word(b + equal_end)) {
+      equal_end += sizeof(uint64_t);
+    }
+    while (equal_end < size && a[equal_end] == b[equal_end]) {
+      equal_end++;
+    }
+    if (equal_end == size) {
+      return (size_t)(out - start);
+    }
+
+    size_t differ_end = equal_end;
+    for (size_t i = equal_end; i < size && i - differ_end < MIN_EQUAL_RUN; i++) {
+      if (a[i] != b[i]) {
+        differ_end = i + 1;
+      }
+    }
+
+    out = put_varint(out, equal_end - pos);
+    out = put_varint(out, differ_end - equal_end);
+    for (size_t i = equal_end; i < differ_end; i++) {
+      *out++ = a[i] ^ b[i];
+    }
+    pos = differ_end;
+  }
+}
+
+private
+void apply_delta(uint8_t *state, const uint8_t *delta, size_t delta_size) {
+  const uint8_t *end = delta + delta_size;
+
+  while (delta < end) {
+    state += get_varint(&delta);
+    size_t count = get_varint(&delta);
+    for (size_t i = 0; i < count; i++) {
+      *state++ ^= *delta++;
+    }
+  }
+}
+
+private
+rewind_entry_t *entry(rewind_t *rewind, size_t index) {
+  return &rewind->entries[(rewind->first + index) % rewind->entry_capacity];
+}
+
+private
+void drop_oldest(rewind_t *rewind) {
+  rewind->buffer_used -= entry(rewind, 0)->size;
+  rewind->first = (rewind->first + 1) % rewind->entry_capacity;
+  rewind->count--;
+}
+
+// The deltas follow each other through the buffer, wrapping around to its start when the next one
+// does not fit before its end. Finds room for `size` bytes after the newest delta, dropping the
+// oldest ones in the way.
+private
+size_t make_room(rewind_t *rewind, size_t size) {
+  if (rewind->count == rewind->entry_capacity) {
+    drop_oldest(rewind);
+  }
+
+  size_t pos = 0;
+  if (rewind->count > 0) {
+    rewind_entry_t *newest = entry(rewind, rewind->count - 1);
+    pos = newest->offset + newest->size;
+  }
+
+  while (rewind->count > 0) {
+    size_t oldest = entry(rewind, 0)->offset;
+    if (oldest >= pos) {
+      // the free space is between the newest and the oldest delta
+      if (pos + size <= oldest) {
+        break;
+      }
+      drop_oldest(rewind);
+    } else if (pos + size <= rewind->buffer_size) {
+      // the free space is after the newest delta and before the oldest one
+      break;
+    } else {
+      pos = 0;
+    }
+  }
+
+  return rewind->count == 0 && pos + size > rewind->buffer_size ? 0 : pos;
+}
+
+// Records the state of `nes`, call it once per frame
+void rewind_push(rewind_t *rewind, const nes_t *nes) {
+  savestate_save(nes, rewind->next);
+
+  if (rewind->has_state) {
+    size_t size = encode_delta(rewind->encoded, (const uint8_t *)rewind->current,
+                               (const uint8_t *)rewind->next, sizeof(savestate_t));
+
+    if (size > rewind->buffer_size) {
+      // cannot be stepped back over, the history before it is useless
+      rewind_clear(rewind);
+    } else {
+      size_t offset = make_room(rewind, size);
+      memcpy(rewind->buffer + offset, rewind->encoded, size);
+      *entry(rewind, rewind->count++) = (rewind_entry_t){(uint32_t)offset, (uint32_t)size};
+      rewind->buffer_used += size;
+    }
+  }
+
+  savestate_t *previous = rewind->current;
+  rewind->current = rewind->next;
+  rewind->next = previous;
+  rewind->has_state = true;
+}
+
+// Steps back to the state pushed before the newest one and loads it. The newest state is dropped,
+// so that repeated calls keep going back one frame at a time. Returns false once the history is
+// exhausted.
+bool rewind_pop(rewind_t *rewind, nes_t *nes) {
+  if (rewind->count == 0) {
+    return false;
+  }
+
+  rewind_entry_t *newest = entry(rewind, rewind->count - 1);
+  apply_delta((uint8_t *)rewind->current, rewind->buffer + newest->offset, newest->size);
+  rewind->buffer_used -= newest->size;
+  rewind->count--;
+
+  return savestate_load(nes, rewind->current);
+}
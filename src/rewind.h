@@ -0,0 +1,57 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "alloc.h"
+#include "nes.h"
+#include "savestate.h"
+
+// History of save states for stepping backwards, one per rewind_push(). Only the newest state is
+// kept whole. Every older one is stored as the XOR of it and its successor, run length encoded:
+// between two frames most of the blob does not change, so the XOR is mostly zeros and a frame
+// typically takes a few hundred bytes.
+//
+// The deltas live in a byte ring, the oldest ones are dropped when it is full.
+
+typedef struct {
+  uint32_t offset;  // into buffer
+  uint32_t size;
+} rewind_entry_t;
+
+typedef struct {
+  savestate_t *current;  // the newest state, the deltas lead back from it
+  savestate_t *next;     // where rewind_push() saves to before encoding it against `current`
+  bool has_state;
+
+  uint8_t *encoded;  // a delta is encoded here first, it is only copied in once it is known to fit
+  uint8_t *buffer;
+  size_t buffer_size;
+  size_t buffer_used;
+
+  rewind_entry_t *entries;  // ring of the deltas, oldest first
+  size_t entry_capacity;
+  size_t first;
+  size_t count;
+} rewind_t;
+
+[[nodiscard]] bool rewind_init(arena_t *arena, rewind_t *rewind, size_t buffer_size,
+                               size_t max_frames);
+void rewind_push(rewind_t *rewind, const nes_t *nes);
+[[nodiscard]] bool rewind_pop(rewind_t *rewind, nes_t *nes);
+void rewind_clear(rewind_t *rewind);
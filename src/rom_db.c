@@ -0,0 +1,44 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#include "rom_db.h"
+
+// tools/rom_db_check is built against a table generated from its own CSV
+#ifdef ROM_DB_ENTRIES
+#include ROM_DB_ENTRIES
+#else
+#include "rom_db_entries.h"
+#endif
+
+size_t rom_db_size(void) { return ROM_DB_ENTRY_COUNT; }
+
+// A branchless binary search over the sorted entries: the loop always runs log2(count) times, so
+// a lookup costs a handful of cache misses at most whether the ROM is known or not
+const rom_db_entry_t *rom_db_find(uint32_t crc32) {
+  const rom_db_entry_t *base = rom_db_entries;
+  size_t count = ROM_DB_ENTRY_COUNT;
+
+  if (count == 0) {
+    return nullptr;
+  }
+
+  while (count > 1) {
+    size_t half = count / 2;
+    base = base[half].crc32 <= crc32 ? base + half : base;
+    count -= half;
+  }
+
+  return base->crc32 == crc32 ? base : nullptr;
+}
@@ -0,0 +1,37 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "load_rom.h"
+
+// A ROM whose iNES header is known to be wrong, with the header fields it should have had. Keyed by
+// the CRC-32 of its PRG ROM followed by its CHR ROM, so a fixed or missing header does not change
+// the key. The entries are generated into rom_db_entries.h by tools/rom_db_gen from rom_db.csv.
+typedef struct {
+  uint32_t crc32;
+  uint16_t mapper_number;
+  uint8_t submapper_number;
+  uint8_t hard_wired_nametable_layout;  // hard_wired_nametable_layout_t
+  bool alternative_nametables;
+  bool battery_present;
+  uint8_t cpu_ppu_timing;  // cpu_ppu_timing_t
+} rom_db_entry_t;
+
+size_t rom_db_size(void);
+const rom_db_entry_t *rom_db_find(uint32_t crc32);
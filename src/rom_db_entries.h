@@ -0,0 +1,26 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+// Generated by tools/rom_db_gen from rom_db.csv, do not edit
+#pragma once
+
+#include "rom_db.h"
+
+static constexpr size_t ROM_DB_ENTRY_COUNT = 0;
+
+// sorted by crc32, the last entry only keeps the array from being empty
+static const rom_db_entry_t rom_db_entries[ROM_DB_ENTRY_COUNT + 1] = {
+    {},
+};
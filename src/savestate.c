@@ -0,0 +1,86 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#include "savestate.h"
+
+#include <string.h>
+
+#include "utils.h"
+
+static constexpr char SAVESTATE_MAGIC[4] = {'N', 'E', 'S', 'S'};
+
+private
+savestate_header_t make_header(const nes_t *nes) {
+  savestate_header_t header = {
+      .version = SAVESTATE_VERSION,
+      .mapper_number = nes->mapper.info->number,
+      .size = sizeof(savestate_t),
+      .prg_rom_size = (uint32_t)nes->mapper.prg_rom_size,
+      .chr_size = (uint32_t)nes->mapper.chr_size,
+      .master_clocks_per_cpu_cycle = (uint32_t)nes->master_clocks_per_cpu_cycle,
+  };
+  memcpy(header.magic, SAVESTATE_MAGIC, sizeof(header.magic));
+  return header;
+}
+
+// Needs a cartridge to be inserted
+void savestate_save(const nes_t *nes, savestate_t *state) {
+  state->header = make_header(nes);
+  memcpy(state->cpu, &nes->cpu, sizeof(state->cpu));
+  state->open_bus = nes->cpu.bus.open_bus;
+  state->ppu = nes->ppu.state;
+  memcpy(state->sprite_line, nes->ppu.sprite_line, sizeof(state->sprite_line));
+  state->apu = nes->apu.state;
+  memcpy(state->apu_deltas, nes->apu.deltas, sizeof(state->apu_deltas));
+  state->mapper = nes->mapper.state;
+  state->controllers = nes->controllers;
+  memcpy(state->scheduler, &nes->scheduler, sizeof(state->scheduler));
+}
+
+// Only states saved with the same cartridge inserted can be loaded, `nes` is left untouched if the
+// state does not fit it
+bool savestate_load(nes_t *nes, const savestate_t *state) {
+  savestate_header_t expected = make_header(nes);
+  const savestate_header_t *header = &state->header;
+
+  return_value_if(memcmp(header->magic, SAVESTATE_MAGIC, sizeof(header->magic)) != 0, false,
+                  "not a save state");
+  return_value_if(header->version != expected.version || header->size != expected.size, false,
+                  "save state version %u is not supported (expected %u)", header->version,
+                  expected.version);
+  return_value_if(header->mapper_number != expected.mapper_number ||
+                      header->prg_rom_size != expected.prg_rom_size ||
+                      header->chr_size != expected.chr_size ||
+                      header->master_clocks_per_cpu_cycle != expected.master_clocks_per_cpu_cycle,
+                  false, "save state was made with a different cartridge");
+
+  // The banks are switched while the rest of the console is still in its old state, so that the
+  // PPU catches up the old timeline before its CHR pages change, not the loaded one
+  nes->mapper.state = state->mapper;
+  mapper_update_banks(&nes->mapper);
+
+  memcpy(&nes->cpu, state->cpu, sizeof(state->cpu));
+  nes->cpu.bus.open_bus = state->open_bus;
+  nes->ppu.state = state->ppu;
+  memcpy(nes->ppu.sprite_line, state->sprite_line, sizeof(state->sprite_line));
+  ppu_state_changed(&nes->ppu);
+  nes->apu.state = state->apu;
+  memcpy(nes->apu.deltas, state->apu_deltas, sizeof(state->apu_deltas));
+  nes->apu.sample_count = 0;
+  nes->controllers = state->controllers;
+  memcpy(&nes->scheduler, state->scheduler, sizeof(state->scheduler));
+
+  return true;
+}
@@ -0,0 +1,57 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nes.h"
+
+// Bump whenever the layout of savestate_t or of any state struct in it changes
+static constexpr uint16_t SAVESTATE_VERSION = 3;
+
+typedef struct {
+  char magic[4];  // "NESS"
+  uint16_t version;
+  uint16_t mapper_number;
+  uint32_t size;  // sizeof(savestate_t)
+  uint32_t prg_rom_size;
+  uint32_t chr_size;
+  uint32_t master_clocks_per_cpu_cycle;
+} savestate_header_t;
+
+// A snapshot of the console as one flat blob. Every section is a pointer free part of a component
+// copied as is, so saving and loading are a handful of memcpy()s. Pointers into the cartridge and
+// between components are rebuilt on load. The blob is only meant to be loaded by the same build on
+// the same machine: it is written in native byte order and struct layout.
+//
+// The framebuffer and the finished audio samples are not part of it. Both are complete again after
+// the next nes_run_frame().
+typedef struct {
+  savestate_header_t header;
+  uint8_t cpu[offsetof(cpu_t, bus)];  // registers, cycle counter, interrupt lines and RAM
+  uint8_t open_bus;
+  ppu_state_t ppu;
+  uint8_t sprite_line[PPU_SCREEN_WIDTH];
+  apu_state_t apu;
+  int32_t apu_deltas[APU_MAX_BLOCK_SAMPLES + APU_KERNEL_TAPS];
+  mapper_state_t mapper;
+  controllers_t controllers;
+  uint8_t scheduler[offsetof(scheduler_t, handlers)];  // the pending events
+} savestate_t;
+
+void savestate_save(const nes_t *nes, savestate_t *state);
+[[nodiscard]] bool savestate_load(nes_t *nes, const savestate_t *state);
@@ -0,0 +1,152 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#include "scheduler.h"
+
+#include "utils.h"
+
+// events due at the same time fire in the order of their type, which keeps runs deterministic
+private
+bool is_earlier(event_t a, event_t b) {
+  return a.when < b.when || (a.when == b.when && a.type < b.type);
+}
+
+private
+void place(scheduler_t *scheduler, uint8_t index, event_t event) {
+  scheduler->heap[index] = event;
+  scheduler->heap_index[event.type] = (int8_t)index;
+}
+
+private
+void sift_up(scheduler_t *scheduler, uint8_t index) {
+  event_t event = scheduler->heap[index];
+
+  while (index > 0) {
+    uint8_t parent = (uint8_t)((index - 1) / 2);
+    if (!is_earlier(event, scheduler->heap[parent])) {
+      break;
+    }
+    place(scheduler, index, scheduler->heap[parent]);
+    index = parent;
+  }
+
+  place(scheduler, index, event);
+}
+
+private
+void sift_down(scheduler_t *scheduler, uint8_t index) {
+  event_t event = scheduler->heap[index];
+
+  for (;;) {
+    uint8_t child = (uint8_t)(2 * index + 1);
+    if (child >= scheduler->heap_size) {
+      break;
+    }
+    if (child + 1 < scheduler->heap_size &&
+        is_earlier(scheduler->heap[child + 1], scheduler->heap[child])) {
+      child++;
+    }
+    if (!is_earlier(scheduler->heap[child], event)) {
+      break;
+    }
+    place(scheduler, index, scheduler->heap[child]);
+    index = child;
+  }
+
+  place(scheduler, index, event);
+}
+
+void scheduler_init(scheduler_t *scheduler) {
+  scheduler->heap_size = 0;
+
+  for (uint8_t type = 0; type < EVENT_COUNT; type++) {
+    scheduler->heap_index[type] = -1;
+    scheduler->handlers[type] = nullptr;
+    scheduler->ctx[type] = nullptr;
+  }
+  scheduler->on_earlier_event = nullptr;
+  scheduler->on_earlier_event_ctx = nullptr;
+}
+
+void scheduler_set_handler(scheduler_t *scheduler, event_type_t type, event_handler_t handler,
+                           void *ctx) {
+  scheduler->handlers[type] = handler;
+  scheduler->ctx[type] = ctx;
+}
+
+void scheduler_set_earlier_event_handler(scheduler_t *scheduler, event_handler_t handler,
+                                         void *ctx) {
+  scheduler->on_earlier_event = handler;
+  scheduler->on_earlier_event_ctx = ctx;
+}
+
+// Schedules `type` at `when`, moving it if it is already pending. If it becomes the next event the
+// earlier event handler is told, an event moved later never needs it.
+void scheduler_schedule(scheduler_t *scheduler, event_type_t type, uint64_t when) {
+  int8_t index = scheduler->heap_index[type];
+  event_t event = {when, type};
+
+  if (index < 0) {
+    place(scheduler, scheduler->heap_size, event);
+    sift_up(scheduler, scheduler->heap_size++);
+  } else if (is_earlier(event, scheduler->heap[index])) {
+    scheduler->heap[index] = event;
+    sift_up(scheduler, (uint8_t)index);
+  } else {
+    scheduler->heap[index] = event;
+    sift_down(scheduler, (uint8_t)index);
+    return;
+  }
+
+  if (scheduler->heap[0].type == type && scheduler->on_earlier_event != nullptr) {
+    scheduler->on_earlier_event(scheduler->on_earlier_event_ctx, when);
+  }
+}
+
+void scheduler_cancel(scheduler_t *scheduler, event_type_t type) {
+  int8_t index = scheduler->heap_index[type];
+  if (index < 0) {
+    return;
+  }
+
+  scheduler->heap_index[type] = -1;
+  scheduler->heap_size--;
+
+  if (index == scheduler->heap_size) {
+    return;
+  }
+
+  // move the last event into the hole and restore the heap property in whichever direction it
+  // is violated
+  event_t last = scheduler->heap[scheduler->heap_size];
+  bool earlier = is_earlier(last, scheduler->heap[index]);
+  place(scheduler, (uint8_t)index, last);
+
+  if (earlier) {
+    sift_up(scheduler, (uint8_t)index);
+  } else {
+    sift_down(scheduler, (uint8_t)index);
+  }
+}
+
+// Fires every event due at or before `now` in time order. A handler may schedule its own event
+// again, if the new time is also due it fires again within this call.
+void scheduler_run_due(scheduler_t *scheduler, uint64_t now) {
+  while (scheduler->heap_size > 0 && scheduler->heap[0].when <= now) {
+    event_t event = scheduler->heap[0];
+    scheduler_cancel(scheduler, event.type);
+    scheduler->handlers[event.type](scheduler->ctx[event.type], event.when);
+  }
+}
@@ -0,0 +1,75 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#pragma once
+
+#include <stdint.h>
+
+// All timing is expressed in master clock ticks. The CPU and the PPU are clocked by dividing the
+// master clock (12 and 4 on NTSC, 16 and 5 on PAL, 15 and 5 on Dendy). Components do not run in
+// lockstep. The CPU runs up to the next pending event, then that event's handler lets its
+// component catch up in one batch.
+static constexpr uint64_t NTSC_MASTER_CLOCKS_PER_CPU_CYCLE = 12;
+static constexpr uint64_t NTSC_MASTER_CLOCKS_PER_PPU_DOT = 4;
+static constexpr uint64_t PAL_MASTER_CLOCKS_PER_CPU_CYCLE = 16;
+static constexpr uint64_t PAL_MASTER_CLOCKS_PER_PPU_DOT = 5;
+static constexpr uint64_t DENDY_MASTER_CLOCKS_PER_CPU_CYCLE = 15;
+static constexpr uint64_t DENDY_MASTER_CLOCKS_PER_PPU_DOT = 5;
+
+typedef enum {
+  EVENT_PPU_SCANLINE,
+  EVENT_APU_FRAME_COUNTER,
+  EVENT_DMC_FETCH,
+  EVENT_MAPPER_IRQ,
+  EVENT_COUNT
+} event_type_t;
+
+typedef void (*event_handler_t)(void *ctx, uint64_t when);
+
+typedef struct {
+  uint64_t when;
+  event_type_t type;
+} event_t;
+
+// Every event type is pending at most once, so the heap never holds more than EVENT_COUNT entries
+// and `heap_index` tracks where each type sits so that it can be moved or cancelled in O(log n)
+typedef struct {
+  event_t heap[EVENT_COUNT];
+  int8_t heap_index[EVENT_COUNT];  // -1 when the event is not pending
+  uint8_t heap_size;
+  event_handler_t handlers[EVENT_COUNT];
+  void *ctx[EVENT_COUNT];
+  // Called when an event is scheduled ahead of every pending one, so that whoever is running up
+  // to the previous next event can stop earlier
+  event_handler_t on_earlier_event;
+  void *on_earlier_event_ctx;
+} scheduler_t;
+
+void scheduler_init(scheduler_t *scheduler);
+void scheduler_set_handler(scheduler_t *scheduler, event_type_t type, event_handler_t handler,
+                           void *ctx);
+void scheduler_set_earlier_event_handler(scheduler_t *scheduler, event_handler_t handler,
+                                         void *ctx);
+void scheduler_schedule(scheduler_t *scheduler, event_type_t type, uint64_t when);
+void scheduler_cancel(scheduler_t *scheduler, event_type_t type);
+void scheduler_run_due(scheduler_t *scheduler, uint64_t now);
+
+static inline uint64_t scheduler_next_event(const scheduler_t *scheduler) {
+  return scheduler->heap_size > 0 ? scheduler->heap[0].when : UINT64_MAX;
+}
+
+static inline bool scheduler_is_pending(const scheduler_t *scheduler, event_type_t type) {
+  return scheduler->heap_index[type] >= 0;
+}
@@ -0,0 +1,397 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+// Measures how fast the CPU executes every opcode, every addressing mode and a few typical code
+// patterns, and prints the results as JSON so that they can be compared across versions.
+//
+// Every benchmark is a small program in a 32KiB buffer mapped at $8000, executed with cpu_step()
+// a fixed number of instructions per sample. Most opcodes are repeated back to back with a JMP at
+// the end, jumps, calls and returns run in a loop on themselves. The operands always point into
+// internal RAM. An addressing mode is summarized over the opcodes that use it.
+//
+// The process is pinned to one CPU and the first sample of every benchmark is thrown away. Each
+// result has the median and variance of the time per instruction over the samples.
+//
+// usage: cpu_bench [-n instructions] [-s samples] [-c cpu]
+//   -n  instructions per sample, 100000 by default
+//   -s  samples per benchmark, 11 by default
+//   -c  CPU to pin to, the one it starts on by default
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../cpu.h"
+#include "../utils.h"
+#include "tool_utils.h"
+
+static constexpr uint16_t PROGRAM_START = 0x8000;
+static constexpr size_t PROGRAM_SIZE = 32 * 1024;
+static constexpr uint16_t IRQ_VECTOR = 0xFFFE;
+static constexpr size_t REPEATED_INSTRUCTIONS = 1024;
+static constexpr size_t MAX_SAMPLES = 1024;
+
+// Operands of the repeated instructions: zero page $10, absolute $0210, and every zero page
+// pointer reads as $0303. Indexed by any X or Y they all stay inside internal RAM.
+static constexpr uint8_t OPERAND_LO = 0x10;
+static constexpr uint8_t OPERAND_HI = 0x02;
+static constexpr uint8_t ZERO_PAGE_FILL = 0x03;
+// RTS and RTI pull $8080 from a stack full of $80, RTS then continues at $8081
+static constexpr uint8_t STACK_FILL = 0x80;
+static constexpr uint16_t RTI_START = 0x8080;
+static constexpr uint16_t RTS_START = 0x8081;
+
+typedef struct {
+  double median_ns;  // per instruction
+  double mean_ns;
+  double variance_ns2;
+  double min_ns;
+  double cycles_per_instruction;
+} bench_result_t;
+
+typedef struct {
+  cpu_t cpu;
+  uint8_t program[PROGRAM_SIZE];
+  size_t instructions;  // per sample
+  size_t samples;
+} bench_t;
+
+typedef struct {
+  const char *name;
+  const char *description;
+  const uint8_t *code;  // loaded at $8000 and run from there
+  size_t size;
+  // zero page pointers, for the indirect modes
+  uint16_t ptr_10;
+  uint16_t ptr_12;
+} mix_t;
+
+// clang-format off
+static const uint8_t tight_loop[] = {
+  0xA2, 0x00,        // $8000  LDX #$00
+  0xCA,              // $8002  DEX
+  0xD0, 0xFD,        // $8003  BNE $8002
+  0x4C, 0x00, 0x80,  // $8005  JMP $8000
+};
+
+static const uint8_t memcpy_loop[] = {
+  0xA0, 0x00,        // $8000  LDY #$00
+  0xB1, 0x10,        // $8002  LDA ($10),Y
+  0x91, 0x12,        // $8004  STA ($12),Y
+  0xC8,              // $8006  INY
+  0xD0, 0xF9,        // $8007  BNE $8002
+  0x4C, 0x00, 0x80,  // $8009  JMP $8000
+};
+
+static const uint8_t jsr_rts[] = {
+  0x20, 0x10, 0x80,  // $8000  JSR $8010
+  0x20, 0x10, 0x80,  // $8003  JSR $8010
+  0x20, 0x20, 0x80,  // $8006  JSR $8020
+  0x4C, 0x00, 0x80,  // $8009  JMP $8000
+  0xEA, 0xEA, 0xEA, 0xEA,
+  0x20, 0x20, 0x80,  // $8010  JSR $8020
+  0x60,              // $8013  RTS
+  0xEA, 0xEA, 0xEA, 0xEA, 0xEA, 0xEA, 0xEA, 0xEA, 0xEA, 0xEA, 0xEA, 0xEA,
+  0xE8,              // $8020  INX
+  0x60,              // $8021  RTS
+};
+
+static const uint8_t add16[] = {
+  0x18,              // $8000  CLC
+  0xA5, 0x20,        // $8001  LDA $20
+  0x69, 0x01,        // $8003  ADC #$01
+  0x85, 0x20,        // $8005  STA $20
+  0xA5, 0x21,        // $8007  LDA $21
+  0x69, 0x00,        // $8009  ADC #$00
+  0x85, 0x21,        // $800B  STA $21
+  0x4C, 0x00, 0x80,  // $800D  JMP $8000
+};
+// clang-format on
+
+static const mix_t mixes[] = {
+    {"tight_loop", "DEX/BNE countdown", tight_loop, sizeof(tight_loop), 0, 0},
+    {"memcpy", "LDA (zp),Y / STA (zp),Y page copy", memcpy_loop, sizeof(memcpy_loop), 0x0300,
+     0x0400},
+    {"jsr_rts", "nested subroutine calls", jsr_rts, sizeof(jsr_rts), 0, 0},
+    {"add16", "16 bit counter in zero page", add16, sizeof(add16), 0, 0},
+};
+
+private
+size_t instruction_length(addressing_modes_t mode) {
+  switch (mode) {
+    case ADDRESSING_ACCUMULATOR:
+    case ADDRESSING_IMPLICIT:
+    case ADDRESSING_NONE:
+      return 1;
+    case ADDRESSING_ABSOLUTE:
+    case ADDRESSING_ABSOLUTE_X:
+    case ADDRESSING_ABSOLUTE_X_W:
+    case ADDRESSING_ABSOLUTE_Y:
+    case ADDRESSING_ABSOLUTE_Y_W:
+    case ADDRESSING_INDIRECT:
+      return 3;
+    default:
+      return 2;
+  }
+}
+
+// Powers the CPU on with the program buffer mapped at $8000 and the RAM filled as the operands
+// expect
+private
+void reset_cpu(bench_t *bench, uint16_t start) {
+  cpu_t *cpu = &bench->cpu;
+  cpu_power_on(cpu);
+  bus_map_read_memory(&cpu->bus, PROGRAM_START, 0xFFFF, bench->program, PROGRAM_SIZE);
+  bus_map_write_memory(&cpu->bus, PROGRAM_START, 0xFFFF, bench->program, PROGRAM_SIZE);
+
+  memset(cpu->mem, ZERO_PAGE_FILL, 0x100);
+  memset(cpu->mem + 0x100, STACK_FILL, 0x100);
+  cpu->pc = start;
+  cpu->s.val = 0x24;  // interrupts are never raised, the flag only matters for CLI/SEI
+}
+
+private
+int compare_doubles(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// Runs the program that reset_cpu() set up, one warm up sample and then the measured ones
+private
+bench_result_t run_samples(bench_t *bench) {
+  cpu_t *cpu = &bench->cpu;
+  double samples[MAX_SAMPLES];
+  uint64_t start_cycles = 0;
+
+  for (size_t sample = 0; sample <= bench->samples; sample++) {
+    if (sample == 1) {
+      start_cycles = cpu->cycles;
+    }
+
+    uint64_t start = now_ns();
+    for (size_t i = 0; i < bench->instructions; i++) {
+      cpu_step(cpu);
+    }
+    if (sample > 0) {
+      samples[sample - 1] = (double)(now_ns() - start) / (double)bench->instructions;
+    }
+  }
+
+  size_t count = bench->samples;
+  qsort(samples, count, sizeof(*samples), compare_doubles);
+
+  bench_result_t result = {.min_ns = samples[0]};
+  result.median_ns = count % 2 ? samples[count / 2]
+                               : (samples[count / 2 - 1] + samples[count / 2]) / 2;
+  for (size_t i = 0; i < count; i++) {
+    result.mean_ns += samples[i] / (double)count;
+  }
+  for (size_t i = 0; i < count; i++) {
+    double d = samples[i] - result.mean_ns;
+    result.variance_ns2 += count > 1 ? d * d / (double)(count - 1) : 0;
+  }
+  result.cycles_per_instruction =
+      (double)(cpu->cycles - start_cycles) / (double)(count * bench->instructions);
+  return result;
+}
+
+private
+bench_result_t bench_opcode(bench_t *bench, uint8_t op) {
+  uint8_t *program = bench->program;
+  memset(program, 0xEA, PROGRAM_SIZE);
+  program[IRQ_VECTOR - PROGRAM_START] = (uint8_t)PROGRAM_START;
+  program[IRQ_VECTOR - PROGRAM_START + 1] = PROGRAM_START >> 8;
+
+  uint16_t start = PROGRAM_START;
+  switch (op) {
+    case 0x00:  // BRK, through the IRQ vector back to itself
+      program[0] = op;
+      break;
+    case 0x20:  // JSR $8000
+    case 0x4C:  // JMP $8000
+      program[0] = op;
+      program[1] = (uint8_t)PROGRAM_START;
+      program[2] = PROGRAM_START >> 8;
+      break;
+    case 0x6C:  // JMP ($0210), which points at itself
+      program[0] = op;
+      program[1] = OPERAND_LO;
+      program[2] = OPERAND_HI;
+      break;
+    case 0x40:
+      start = RTI_START;
+      program[start - PROGRAM_START] = op;
+      break;
+    case 0x60:
+      start = RTS_START;
+      program[start - PROGRAM_START] = op;
+      break;
+    default: {
+      // relative branches get an offset of 0, taken or not they continue with the next one
+      size_t length = instruction_length(cpu_addressing_mode(op));
+      uint8_t operands[] = {cpu_addressing_mode(op) == ADDRESSING_RELATIVE ? 0 : OPERAND_LO,
+                            OPERAND_HI};
+      uint8_t *pos = program;
+      for (size_t i = 0; i < REPEATED_INSTRUCTIONS; i++) {
+        *pos++ = op;
+        memcpy(pos, operands, length - 1);
+        pos += length - 1;
+      }
+      pos[0] = 0x4C;  // JMP $8000
+      pos[1] = (uint8_t)PROGRAM_START;
+      pos[2] = PROGRAM_START >> 8;
+    }
+  }
+
+  reset_cpu(bench, start);
+  bench->cpu.mem[(OPERAND_HI << 8) | OPERAND_LO] = (uint8_t)PROGRAM_START;
+  bench->cpu.mem[((OPERAND_HI << 8) | OPERAND_LO) + 1] = PROGRAM_START >> 8;
+  return run_samples(bench);
+}
+
+private
+bench_result_t bench_mix(bench_t *bench, const mix_t *mix) {
+  memset(bench->program, 0xEA, PROGRAM_SIZE);
+  memcpy(bench->program, mix->code, mix->size);
+
+  reset_cpu(bench, PROGRAM_START);
+  uint8_t *mem = bench->cpu.mem;
+  mem[0x10] = (uint8_t)mix->ptr_10;
+  mem[0x11] = (uint8_t)(mix->ptr_10 >> 8);
+  mem[0x12] = (uint8_t)mix->ptr_12;
+  mem[0x13] = (uint8_t)(mix->ptr_12 >> 8);
+  return run_samples(bench);
+}
+
+private
+void print_result(const bench_result_t *result) {
+  printf("\"median_ns\": %.3f, \"mean_ns\": %.3f, \"variance_ns2\": %.6f, \"min_ns\": %.3f, "
+         "\"instructions_per_second\": %.0f, \"cycles_per_instruction\": %.3f",
+         result->median_ns, result->mean_ns, result->variance_ns2, result->min_ns,
+         result->median_ns > 0 ? 1e9 / result->median_ns : 0.0, result->cycles_per_instruction);
+}
+
+// Summarizes the opcodes of every addressing mode, the variants that always take the extra cycle
+// of indexed writes are counted with their read variant, as they share the name
+private
+void print_addressing_modes(const bench_result_t results[256]) {
+  const char *previous = nullptr;
+  bool first = true;
+
+  for (addressing_modes_t mode = ADDRESSING_ABSOLUTE; mode <= ADDRESSING_ZERO_PAGE_Y; mode++) {
+    const char *name = cpu_addressing_mode_name(mode);
+    if (previous != nullptr && strcmp(name, previous) == 0) {
+      continue;
+    }
+    previous = name;
+
+    double medians[256];
+    size_t count = 0;
+    double cycles = 0;
+    for (int op = 0; op < 256; op++) {
+      if (strcmp(cpu_addressing_mode_name(cpu_addressing_mode((uint8_t)op)), name) == 0) {
+        cycles += results[op].cycles_per_instruction;
+        medians[count++] = results[op].median_ns;
+      }
+    }
+    if (count == 0) {
+      continue;
+    }
+
+    qsort(medians, count, sizeof(*medians), compare_doubles);
+    double mean = 0;
+    for (size_t i = 0; i < count; i++) {
+      mean += medians[i] / (double)count;
+    }
+    double variance = 0;
+    for (size_t i = 0; i < count; i++) {
+      variance += count > 1 ? (medians[i] - mean) * (medians[i] - mean) / (double)(count - 1) : 0;
+    }
+
+    printf("%s\n    {\"name\": \"%s\", \"opcodes\": %zu, \"median_ns\": %.3f, \"mean_ns\": %.3f, "
+           "\"variance_ns2\": %.6f, \"min_ns\": %.3f, \"max_ns\": %.3f, "
+           "\"cycles_per_instruction\": %.3f}",
+           first ? "" : ",", name, count, medians[count / 2], mean, variance, medians[0],
+           medians[count - 1], cycles / (double)count);
+    first = false;
+  }
+}
+
+int main(int argc, char **argv) {
+  long instructions = 100000;
+  long samples = 11;
+  int cpu_index = -1;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:s:c:")) != -1) {
+    switch (opt) {
+      case 'n':
+        instructions = strtol(optarg, nullptr, 10);
+        break;
+      case 's':
+        samples = strtol(optarg, nullptr, 10);
+        break;
+      case 'c':
+        cpu_index = (int)strtol(optarg, nullptr, 10);
+        break;
+      default:
+        return EXIT_FAILURE;
+    }
+  }
+  return_value_if(optind != argc || instructions < 1 || samples < 1 ||
+                      (size_t)samples > MAX_SAMPLES,
+                  EXIT_FAILURE, "usage: %s [-n instructions] [-s samples (1-%zu)] [-c cpu]",
+                  argv[0], (size_t)MAX_SAMPLES);
+
+  cpu_index = pin_to_cpu(cpu_index);
+
+  bench_t *bench = calloc(1, sizeof(*bench));
+  return_value_if(bench == nullptr, EXIT_FAILURE, "out of memory");
+  bench->instructions = (size_t)instructions;
+  bench->samples = (size_t)samples;
+
+  static bench_result_t results[256];
+  for (int op = 0; op < 256; op++) {
+    results[op] = bench_opcode(bench, (uint8_t)op);
+  }
+
+  printf("{\n  \"benchmark\": \"cpu_bench\",\n  \"format\": 1,\n  \"timestamp\": %lld,\n"
+         "  \"compiler\": \"%s\",\n  \"pinned_cpu\": %d,\n  \"samples\": %zu,\n"
+         "  \"instructions_per_sample\": %zu,\n  \"opcodes\": [",
+         (long long)time(nullptr), __VERSION__, cpu_index, bench->samples, bench->instructions);
+  for (int op = 0; op < 256; op++) {
+    addressing_modes_t mode = cpu_addressing_mode((uint8_t)op);
+    printf("%s\n    {\"opcode\": \"0x%02x\", \"name\": \"%s\", \"addressing_mode\": \"%s\", ",
+           op ? "," : "", op, cpu_opcode_name((uint8_t)op), cpu_addressing_mode_name(mode));
+    print_result(&results[op]);
+    putchar('}');
+  }
+
+  printf("\n  ],\n  \"addressing_modes\": [");
+  print_addressing_modes(results);
+
+  printf("\n  ],\n  \"mixes\": [");
+  for (size_t i = 0; i < sizeof(mixes) / sizeof(*mixes); i++) {
+    bench_result_t result = bench_mix(bench, &mixes[i]);
+    printf("%s\n    {\"name\": \"%s\", \"description\": \"%s\", ", i ? "," : "", mixes[i].name,
+           mixes[i].description);
+    print_result(&result);
+    putchar('}');
+  }
+  printf("\n  ]\n}\n");
+
+  free(bench);
+  return EXIT_SUCCESS;
+}
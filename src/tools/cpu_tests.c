@@ -0,0 +1,542 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+// Runs the https://github.com/SingleStepTests/65x02 conformance tests (the nes6502 set) against
+// the CPU. Every opcode has its own JSON file with thousands of cases, each giving the registers
+// and memory before and after a single instruction and the bus access of every cycle in between.
+//
+// The files are mapped and parsed in place, one case at a time, into a fixed size struct on the
+// stack, so nothing is allocated per case no matter how large a file is. The files are shared
+// out to a pool of threads, each running its own CPU.
+//
+// Build with -DCPU_TESTS -DCPU_BUS_LOG -DTRACE_LEVEL=0, the CPU then sees 64KiB of RAM and logs
+// every bus access, the expected accesses are parsed into the same log format and compared as is.
+//
+// usage: cpu_tests [-j threads] [-a] <file or directory>...
+//   -j  number of threads, the number of online CPUs by default
+//   -a  print every failing case instead of only the first one of each file
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <threads.h>
+#include <unistd.h>
+
+#include "../alloc.h"
+#include "../cpu.h"
+#include "../trace.h"
+#include "../utils.h"
+#include "tool_utils.h"
+
+#if !defined(CPU_TESTS) || !defined(CPU_BUS_LOG)
+#error "cpu_tests has to be built with -DCPU_TESTS -DCPU_BUS_LOG"
+#endif
+
+#if TRACE_LEVEL != TRACE_LEVEL_OFF
+#warning "cpu_tests is built with tracing, every case will be logged"
+#endif
+
+static constexpr size_t ARENA_BLOCK_SIZE = 256 * 1024;
+static constexpr size_t MAX_RAM_ENTRIES = 32;
+static constexpr size_t MAX_FAILURE_LENGTH = 256;
+
+static const char *const test_extensions[] = {".json", nullptr};
+
+typedef struct {
+  uint16_t addr;
+  uint8_t val;
+} ram_entry_t;
+
+typedef struct {
+  uint16_t pc;
+  uint8_t sp;
+  uint8_t ac;
+  uint8_t x;
+  uint8_t y;
+  uint8_t p;
+  ram_entry_t ram[MAX_RAM_ENTRIES];
+  size_t ram_count;
+} cpu_state_t;
+
+// Strings point into the mapped file and are not terminated
+typedef struct {
+  const char *name;
+  size_t name_length;
+  cpu_state_t initial;
+  cpu_state_t final;
+  cpu_bus_log_t cycles;
+} test_case_t;
+
+// A cursor into the mapped file. The first syntax error clears `ok`, from then on every read
+// returns nothing so that the callers only have to check once per case.
+typedef struct {
+  const char *pos;
+  const char *end;
+  bool ok;
+} json_t;
+
+typedef struct {
+  bool ok;  // false if the file could not be read or parsed
+  size_t passed;
+  size_t failed;
+  char first_failure[MAX_FAILURE_LENGTH];
+} file_result_t;
+
+typedef struct {
+  const path_list_t *paths;
+  file_result_t *results;
+  work_queue_t queue;  // indices into paths
+  bool all_failures;
+} test_job_t;
+
+private
+void json_skip_whitespace(json_t *json) {
+  while (json->pos < json->end &&
+         (*json->pos == ' ' || *json->pos == '\n' || *json->pos == '\r' || *json->pos == '\t')) {
+    json->pos++;
+  }
+}
+
+// Consumes `c` if it is the next token
+private
+bool json_accept(json_t *json, char c) {
+  json_skip_whitespace(json);
+  if (json->ok && json->pos < json->end && *json->pos == c) {
+    json->pos++;
+    return true;
+  }
+  return false;
+}
+
+private
+void json_expect(json_t *json, char c) {
+  if (!json_accept(json, c)) {
+    json->ok = false;
+  }
+}
+
+private
+uint32_t json_uint(json_t *json) {
+  json_skip_whitespace(json);
+
+  uint32_t val = 0;
+  const char *start = json->pos;
+  while (json->pos < json->end && *json->pos >= '0' && *json->pos <= '9' && val <= 0xFFFFFF) {
+    val = val * 10 + (uint32_t)(*json->pos++ - '0');
+  }
+  json->ok = json->ok && json->pos != start;
+  return val;
+}
+
+// The strings of the tests never contain escapes, they are skipped over but not decoded
+private
+void json_string(json_t *json, const char **str, size_t *length) {
+  *str = "";
+  *length = 0;
+  if (!json_accept(json, '"')) {
+    json->ok = false;
+    return;
+  }
+
+  const char *start = json->pos;
+  while (json->pos < json->end && *json->pos != '"') {
+    json->pos += *json->pos == '\\' ? 2 : 1;
+  }
+  if (json->pos >= json->end) {
+    json->ok = false;
+    return;
+  }
+
+  *str = start;
+  *length = (size_t)(json->pos++ - start);
+}
+
+private
+bool json_string_equals(const char *str, size_t length, const char *expected) {
+  return strlen(expected) == length && memcmp(str, expected, length) == 0;
+}
+
+// Skips a value of any type, for keys the runner does not know about
+private
+void json_skip_value(json_t *json) {
+  json_skip_whitespace(json);
+  if (!json->ok || json->pos >= json->end) {
+    json->ok = false;
+    return;
+  }
+
+  const char *str;
+  size_t length;
+  if (*json->pos == '"') {
+    json_string(json, &str, &length);
+  } else if (json_accept(json, '[')) {
+    if (!json_accept(json, ']')) {
+      do {
+        json_skip_value(json);
+      } while (json_accept(json, ','));
+      json_expect(json, ']');
+    }
+  } else if (json_accept(json, '{')) {
+    if (!json_accept(json, '}')) {
+      do {
+        json_string(json, &str, &length);
+        json_expect(json, ':');
+        json_skip_value(json);
+      } while (json_accept(json, ','));
+      json_expect(json, '}');
+    }
+  } else {
+    // numbers, true, false and null
+    while (json->pos < json->end && strchr(",]} \n\r\t", *json->pos) == nullptr) {
+      json->pos++;
+    }
+  }
+}
+
+private
+void parse_ram(json_t *json, cpu_state_t *state) {
+  state->ram_count = 0;
+  json_expect(json, '[');
+  if (json_accept(json, ']')) {
+    return;
+  }
+
+  do {
+    if (state->ram_count == MAX_RAM_ENTRIES) {
+      json->ok = false;
+      return;
+    }
+    ram_entry_t *entry = &state->ram[state->ram_count++];
+    json_expect(json, '[');
+    entry->addr = (uint16_t)json_uint(json);
+    json_expect(json, ',');
+    entry->val = (uint8_t)json_uint(json);
+    json_expect(json, ']');
+  } while (json_accept(json, ','));
+  json_expect(json, ']');
+}
+
+private
+void parse_state(json_t *json, cpu_state_t *state) {
+  json_expect(json, '{');
+  do {
+    const char *key;
+    size_t length;
+    json_string(json, &key, &length);
+    json_expect(json, ':');
+
+    if (json_string_equals(key, length, "pc")) {
+      state->pc = (uint16_t)json_uint(json);
+    } else if (json_string_equals(key, length, "s")) {
+      state->sp = (uint8_t)json_uint(json);
+    } else if (json_string_equals(key, length, "a")) {
+      state->ac = (uint8_t)json_uint(json);
+    } else if (json_string_equals(key, length, "x")) {
+      state->x = (uint8_t)json_uint(json);
+    } else if (json_string_equals(key, length, "y")) {
+      state->y = (uint8_t)json_uint(json);
+    } else if (json_string_equals(key, length, "p")) {
+      state->p = (uint8_t)json_uint(json);
+    } else if (json_string_equals(key, length, "ram")) {
+      parse_ram(json, state);
+    } else {
+      json_skip_value(json);
+    }
+  } while (json->ok && json_accept(json, ','));
+  json_expect(json, '}');
+}
+
+private
+void parse_cycles(json_t *json, cpu_bus_log_t *cycles) {
+  cycles->count = 0;
+  json_expect(json, '[');
+  if (json_accept(json, ']')) {
+    return;
+  }
+
+  do {
+    if (cycles->count == CPU_BUS_LOG_CAPACITY) {
+      json->ok = false;
+      return;
+    }
+    cpu_bus_access_t *cycle = &cycles->accesses[cycles->count++];
+    const char *kind;
+    size_t length;
+
+    json_expect(json, '[');
+    cycle->addr = (uint16_t)json_uint(json);
+    json_expect(json, ',');
+    cycle->val = (uint8_t)json_uint(json);
+    json_expect(json, ',');
+    json_string(json, &kind, &length);
+    json_expect(json, ']');
+
+    cycle->kind = json_string_equals(kind, length, "write") ? BUS_WRITE : BUS_READ;
+    json->ok = json->ok && (cycle->kind == BUS_WRITE || json_string_equals(kind, length, "read"));
+  } while (json_accept(json, ','));
+  json_expect(json, ']');
+}
+
+[[nodiscard]] private
+bool parse_case(json_t *json, test_case_t *test) {
+  *test = (test_case_t){.name = ""};
+
+  json_expect(json, '{');
+  do {
+    const char *key;
+    size_t length;
+    json_string(json, &key, &length);
+    json_expect(json, ':');
+
+    if (json_string_equals(key, length, "name")) {
+      json_string(json, &test->name, &test->name_length);
+    } else if (json_string_equals(key, length, "initial")) {
+      parse_state(json, &test->initial);
+    } else if (json_string_equals(key, length, "final")) {
+      parse_state(json, &test->final);
+    } else if (json_string_equals(key, length, "cycles")) {
+      parse_cycles(json, &test->cycles);
+    } else {
+      json_skip_value(json);
+    }
+  } while (json->ok && json_accept(json, ','));
+  json_expect(json, '}');
+
+  return json->ok;
+}
+
+private
+bool check_register(char *failure, const test_case_t *test, const char *name, unsigned expected,
+                    unsigned actual) {
+  if (expected == actual) {
+    return true;
+  }
+  snprintf(failure, MAX_FAILURE_LENGTH, "%.*s: %s expected %u, got %u", (int)test->name_length,
+           test->name, name, expected, actual);
+  return false;
+}
+
+// Compares the CPU against the end state and bus log of `test`, describes the first difference in
+// `failure`
+private
+bool check_case(const cpu_t *cpu, const test_case_t *test, char *failure) {
+  const cpu_state_t *final = &test->final;
+  if (!check_register(failure, test, "pc", final->pc, cpu->pc) ||
+      !check_register(failure, test, "s", final->sp, cpu->sp) ||
+      !check_register(failure, test, "a", final->ac, cpu->ac) ||
+      !check_register(failure, test, "x", final->x, cpu->x) ||
+      !check_register(failure, test, "y", final->y, cpu->y) ||
+      !check_register(failure, test, "p", final->p, cpu->s.val)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < final->ram_count; i++) {
+    const ram_entry_t *entry = &final->ram[i];
+    if (cpu->mem[entry->addr] != entry->val) {
+      snprintf(failure, MAX_FAILURE_LENGTH, "%.*s: ram[%u] expected %u, got %u",
+               (int)test->name_length, test->name, entry->addr, entry->val, cpu->mem[entry->addr]);
+      return false;
+    }
+  }
+
+  if (cpu_bus_log_equal(&cpu->bus_log, &test->cycles)) {
+    return true;
+  }
+  if (!check_register(failure, test, "cycle count", (unsigned)test->cycles.count,
+                      (unsigned)cpu->bus_log.count)) {
+    return false;
+  }
+
+  size_t i = 0;
+  const cpu_bus_access_t *expected = test->cycles.accesses;
+  const cpu_bus_access_t *actual = cpu->bus_log.accesses;
+  while (memcmp(&expected[i], &actual[i], sizeof(*actual)) == 0) {
+    i++;
+  }
+
+  static const char *kinds[] = {"read", "write"};
+  snprintf(failure, MAX_FAILURE_LENGTH, "%.*s: cycle %zu expected %s %u at %u, got %s %u at %u",
+           (int)test->name_length, test->name, i + 1, kinds[expected[i].kind], expected[i].val,
+           expected[i].addr, kinds[actual[i].kind], actual[i].val, actual[i].addr);
+  return false;
+}
+
+[[nodiscard]] private
+bool run_case(cpu_t *cpu, const test_case_t *test, char *failure) {
+  const cpu_state_t *initial = &test->initial;
+  cpu->pc = initial->pc;
+  cpu->sp = initial->sp;
+  cpu->ac = initial->ac;
+  cpu->x = initial->x;
+  cpu->y = initial->y;
+  cpu->s.val = initial->p;
+  for (size_t i = 0; i < initial->ram_count; i++) {
+    cpu->mem[initial->ram[i].addr] = initial->ram[i].val;
+  }
+  cpu_bus_log_clear(cpu);
+
+  cpu_step(cpu);
+  bool passed = check_case(cpu, test, failure);
+
+  // clearing the 64KiB for every case would cost more than running it, only the bytes that the
+  // case set up or wrote to are put back
+  for (size_t i = 0; i < initial->ram_count; i++) {
+    cpu->mem[initial->ram[i].addr] = 0;
+  }
+  for (size_t i = 0; i < test->cycles.count; i++) {
+    cpu->mem[test->cycles.accesses[i].addr] = 0;
+  }
+  return passed;
+}
+
+// Runs every case of the file at `path`, the file is an array of case objects
+private
+void run_file(cpu_t *cpu, const char *path, file_result_t *result, bool all_failures) {
+  *result = (file_result_t){};
+
+  FILE *filep __attribute__((cleanup(cleanup_file))) = fopen(path, "rb");
+  struct stat st;
+  if (filep == nullptr || fstat(fileno(filep), &st) != 0 || st.st_size <= 0) {
+    snprintf(result->first_failure, MAX_FAILURE_LENGTH, "cannot read file");
+    return;
+  }
+
+  size_t size = (size_t)st.st_size;
+  void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileno(filep), 0);
+  if (data == MAP_FAILED) {
+    snprintf(result->first_failure, MAX_FAILURE_LENGTH, "cannot map file");
+    return;
+  }
+  madvise(data, size, MADV_SEQUENTIAL);
+
+  json_t json = {.pos = data, .end = (const char *)data + size, .ok = true};
+  char failure[MAX_FAILURE_LENGTH];
+  test_case_t test;
+
+  json_expect(&json, '[');
+  if (!json_accept(&json, ']')) {
+    do {
+      if (!parse_case(&json, &test)) {
+        break;
+      }
+      if (run_case(cpu, &test, failure)) {
+        result->passed++;
+        continue;
+      }
+
+      if (result->failed++ == 0) {
+        memcpy(result->first_failure, failure, MAX_FAILURE_LENGTH);
+      }
+      if (all_failures) {
+        log_error("%s: %s", path, failure);
+      }
+    } while (json_accept(&json, ','));
+    json_expect(&json, ']');
+  }
+
+  result->ok = json.ok;
+  if (!json.ok) {
+    snprintf(result->first_failure, MAX_FAILURE_LENGTH, "syntax error at byte %td",
+             json.pos - (const char *)data);
+  }
+  munmap(data, size);
+}
+
+private
+int test_worker(void *arg) {
+  test_job_t *job = arg;
+
+  arena_t arena;
+  if (!arena_new(&arena, ARENA_BLOCK_SIZE)) {
+    return thrd_error;
+  }
+
+  cpu_t *cpu = new (&arena, cpu_t);
+  if (cpu == nullptr) {
+    arena_free(&arena);
+    return thrd_error;
+  }
+  cpu_power_on(cpu);
+
+  size_t i;
+  while (work_queue_take(&job->queue, &i)) {
+    run_file(cpu, job->paths->items[i], &job->results[i], job->all_failures);
+  }
+
+  arena_free(&arena);
+  return thrd_success;
+}
+
+int main(int argc, char **argv) {
+  size_t thread_count = parse_thread_count(nullptr);
+  bool all_failures = false;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "j:a")) != -1) {
+    switch (opt) {
+      case 'j':
+        thread_count = parse_thread_count(optarg);
+        break;
+      case 'a':
+        all_failures = true;
+        break;
+      default:
+        return EXIT_FAILURE;
+    }
+  }
+  return_value_if(optind == argc, EXIT_FAILURE,
+                  "usage: %s [-j threads] [-a] <file or directory>...", argv[0]);
+
+  path_list_t paths = {};
+  for (int i = optind; i < argc; i++) {
+    return_value_if(!collect_paths(&paths, argv[i], test_extensions), EXIT_FAILURE,
+                    "cannot list tests");
+  }
+  sort_paths(&paths);
+
+  file_result_t *results = calloc(paths.count ? paths.count : 1, sizeof(*results));
+  return_value_if(results == nullptr, EXIT_FAILURE, "out of memory");
+
+  test_job_t job = {.paths = &paths, .results = results, .all_failures = all_failures};
+  work_queue_init(&job.queue, 0, paths.count);
+
+  double start = now_seconds();
+  // a thread that could not set up its CPU leaves its share to the others
+  return_value_if(run_threads(thread_count, test_worker, &job, 0) == 0, EXIT_FAILURE,
+                  "cannot start any threads");
+  double seconds = now_seconds() - start;
+
+  size_t passed = 0;
+  size_t failed = 0;
+  size_t broken_files = 0;
+  for (size_t i = 0; i < paths.count; i++) {
+    const file_result_t *result = &results[i];
+    passed += result->passed;
+    failed += result->failed;
+    broken_files += !result->ok;
+
+    if (!result->ok || result->failed > 0) {
+      printf("FAIL %s: %zu/%zu passed, %s\n", paths.items[i], result->passed,
+             result->passed + result->failed, result->first_failure);
+    }
+  }
+
+  printf("%zu/%zu cases passed in %zu files, %zu unreadable, %.2fs (%.0f cases/s)\n", passed,
+         passed + failed, paths.count, broken_files, seconds,
+         seconds > 0 ? (double)(passed + failed) / seconds : 0.0);
+
+  free_paths(&paths);
+  free(results);
+  return failed == 0 && broken_files == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
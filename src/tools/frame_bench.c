@@ -0,0 +1,191 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+// Measures how fast whole consoles run: every ROM is loaded, powered on and run headless for a
+// number of frames, one after the other on a single pinned CPU. Prints JSON with the frames and
+// CPU cycles per second of every ROM and of all of them together.
+//
+// Built with -DNES_PROFILE the time is also split between the CPU, PPU, APU and mapper. The clock
+// is read at every switch, which is slow next to the short catch-ups of a game polling $2002, such
+// a game can run at half speed. The frame rates to compare across versions come from a build
+// without it. Built with -DNES_STATS the counters of every ROM are printed to stderr.
+//
+// usage: frame_bench [-n frames] [-v] [-c cpu] <rom>...
+//   -n  frames to run per ROM, 10000 by default
+//   -v  verify mode: no pixels or samples are produced
+//   -c  CPU to pin to, the one it starts on by default
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../alloc.h"
+#include "../load_rom.h"
+#include "../nes.h"
+#include "../profile.h"
+#include "../utils.h"
+#include "tool_utils.h"
+
+static constexpr uint32_t DEFAULT_FRAMES = 10000;
+static constexpr size_t ARENA_BLOCK_SIZE = 4 * 1024 * 1024;
+
+static const char *component_names[PROFILE_COMPONENT_COUNT] = {"cpu", "ppu", "apu", "mapper"};
+
+typedef struct {
+  uint64_t frames;
+  uint64_t cpu_cycles;
+  double seconds;
+  uint64_t component_ns[PROFILE_COMPONENT_COUNT];
+} bench_result_t;
+
+[[nodiscard]] private
+bool run_rom(arena_t *arena, const char *path, uint32_t frames, bool verify,
+             bench_result_t *result) {
+  arena_scope_t scope = arena_scope_begin(arena);
+  nes_t *nes = new (arena, nes_t);
+  cartridge_t cart = cart_new();
+
+  bool ok = nes != nullptr && load_rom_file(arena, &cart, path);
+  if (ok) {
+    ok = fill_header(&cart);
+    nes_power_on(nes);
+    ok = ok && nes_insert_cartridge(nes, &cart);
+  }
+
+  if (ok) {
+    nes_reset(nes);
+    nes_set_skip_output(nes, verify);
+
+    uint64_t start_cycles = nes->cpu.cycles;
+    double start = now_seconds();
+    profile_reset();
+    for (uint32_t frame = 0; frame < frames; frame++) {
+      nes_run_frame(nes);
+    }
+    profile_read(result->component_ns);
+    result->seconds = now_seconds() - start;
+    result->cpu_cycles = nes->cpu.cycles - start_cycles;
+    result->frames = frames;
+
+#ifdef NES_STATS
+    nes_stats_t stats;
+    nes_get_stats(nes, &stats);
+    fprintf(stderr, "%s:\n", path);
+    nes_print_stats(&stats, stderr);
+#endif
+  }
+
+  cart_release(&cart);
+  arena_scope_end(scope);
+  return ok;
+}
+
+private
+void print_result(const bench_result_t *result) {
+  double seconds = result->seconds > 0 ? result->seconds : 1e-9;
+  printf("\"frames\": %llu, \"seconds\": %.3f, \"fps\": %.1f, \"cpu_cycles_per_second\": %.0f",
+         (unsigned long long)result->frames, result->seconds, (double)result->frames / seconds,
+         (double)result->cpu_cycles / seconds);
+
+#ifdef NES_PROFILE
+  uint64_t total_ns = 0;
+  for (int i = 0; i < PROFILE_COMPONENT_COUNT; i++) {
+    total_ns += result->component_ns[i];
+  }
+  printf(", \"components\": {");
+  for (int i = 0; i < PROFILE_COMPONENT_COUNT; i++) {
+    printf("%s\"%s\": {\"ms\": %.1f, \"percent\": %.1f}", i ? ", " : "", component_names[i],
+           (double)result->component_ns[i] / 1e6,
+           total_ns ? 100.0 * (double)result->component_ns[i] / (double)total_ns : 0.0);
+  }
+  putchar('}');
+#else
+  (void)component_names;
+#endif
+}
+
+int main(int argc, char **argv) {
+  long frames = DEFAULT_FRAMES;
+  bool verify = false;
+  int cpu_index = -1;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:vc:")) != -1) {
+    switch (opt) {
+      case 'n':
+        frames = strtol(optarg, nullptr, 10);
+        break;
+      case 'v':
+        verify = true;
+        break;
+      case 'c':
+        cpu_index = (int)strtol(optarg, nullptr, 10);
+        break;
+      default:
+        return EXIT_FAILURE;
+    }
+  }
+  return_value_if(optind == argc || frames < 1 || frames > UINT32_MAX, EXIT_FAILURE,
+                  "usage: %s [-n frames] [-v] [-c cpu] <rom>...", argv[0]);
+
+  cpu_index = pin_to_cpu(cpu_index);
+
+  arena_t arena;
+  return_value_if(!arena_new(&arena, ARENA_BLOCK_SIZE), EXIT_FAILURE, "out of memory");
+  load_rom_set_verbose(false);
+
+#ifdef NES_PROFILE
+  bool profiled = true;
+#else
+  bool profiled = false;
+#endif
+  printf("{\n  \"benchmark\": \"frame_bench\",\n  \"format\": 1,\n  \"timestamp\": %lld,\n"
+         "  \"compiler\": \"%s\",\n  \"pinned_cpu\": %d,\n  \"verify\": %s,\n"
+         "  \"profiled\": %s,\n  \"roms\": [",
+         (long long)time(nullptr), __VERSION__, cpu_index, verify ? "true" : "false",
+         profiled ? "true" : "false");
+
+  bench_result_t total = {};
+  size_t failed = 0;
+  for (int i = optind; i < argc; i++) {
+    printf("%s\n    {\"rom\": ", i > optind ? "," : "");
+    print_json_string(argv[i]);
+    fflush(stdout);  // errors go to stderr
+
+    bench_result_t result = {};
+    if (!run_rom(&arena, argv[i], (uint32_t)frames, verify, &result)) {
+      printf(", \"error\": \"cannot run ROM\"}");
+      failed++;
+      continue;
+    }
+
+    printf(", ");
+    print_result(&result);
+    putchar('}');
+
+    total.frames += result.frames;
+    total.cpu_cycles += result.cpu_cycles;
+    total.seconds += result.seconds;
+    for (int c = 0; c < PROFILE_COMPONENT_COUNT; c++) {
+      total.component_ns[c] += result.component_ns[c];
+    }
+  }
+
+  printf("\n  ],\n  \"total\": {");
+  print_result(&total);
+  printf("}\n}\n");
+
+  arena_free(&arena);
+  return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
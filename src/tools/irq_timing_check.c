@@ -0,0 +1,252 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+
+// Checks that an event scheduled by a register write while the CPU is running is handled on time,
+// and not only once the CPU reaches the deadline it was started with.
+//
+// A synthetic MMC3 ROM turns rendering on and waits for a flag in RAM. The console is run up to a
+// dot in the middle of a visible scanline, the flag is set, and the rest of the scanline is run in
+// one nes_run_until() call. The ROM then sets the IRQ latch to 0, reloads the counter and enables
+// the IRQ, so the IRQ is predicted at the A12 rise of the same scanline, before the end of the
+// scanline the CPU was running to. Its handler has to run within one instruction of that time, and
+// has to assert the CPU's IRQ line. The IRQ itself is masked, the ROM spins on a JMP.
+//
+// Every dot is run twice: with the IRQ disabled until the ROM enables it, and with it already
+// enabled and pending a few scanlines later, so that the ROM's writes move the pending event
+// earlier instead of adding it.
+//
+// Run a third time, the ROM starts a DMC sample instead. A one byte sample is played at the fastest
+// rate right after reset, so that the output unit keeps running on its own. The ROM's write to
+// $4015 fetches the first byte right away and schedules the next fetch for when the output unit
+// empties the buffer. The flag is set at dots spread over the 8 output cycles between two fetches,
+// counting on from the start of the scanline, so that the fetch falls before the end of the
+// scanline in some of the runs. It has to be made within one instruction of its time as well.
+//
+// usage: irq_timing_check
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../alloc.h"
+#include "../load_rom.h"
+#include "../nes.h"
+#include "../utils.h"
+
+static constexpr size_t PRG_ROM_SIZE = 32 * 1024;
+static constexpr size_t CHR_ROM_SIZE = 8 * 1024;
+static constexpr size_t HEADER_SIZE = 16;
+static constexpr size_t ROM_SIZE = HEADER_SIZE + PRG_ROM_SIZE + CHR_ROM_SIZE;
+static constexpr size_t ARENA_BLOCK_SIZE = 1024 * 1024;
+static constexpr uint16_t FLAG_ADDR = 0x0000;
+static constexpr uint16_t TEST_SCANLINE = 20;
+static constexpr uint8_t ARMED_LATCH = 4;
+static constexpr uint16_t DMC_SCANLINES = 8;  // covers the 8 output cycles to the second fetch
+static constexpr uint16_t DOT_STEP = 20;
+static constexpr uint64_t SPIN_LOOP_CYCLES = 3;  // JMP *
+
+// At $E000, the last 8KiB bank is fixed there
+static constexpr uint8_t program[] = {
+    0x78,                    // SEI
+    0xA9, 0x18,              // LDA #$18
+    0x8D, 0x01, 0x20,        // STA $2001   background and sprites on
+    0xA5, 0x00,              // wait: LDA $00
+    0xF0, 0xFC,              // BEQ wait
+    0xC9, 0x02,              // CMP #$02
+    0xF0, 0x0E,              // BEQ dmc
+    0xA9, 0x00,              // LDA #$00
+    0x8D, 0x00, 0xC0,        // STA $C000   IRQ latch
+    0x8D, 0x01, 0xC0,        // STA $C001   reload
+    0x8D, 0x01, 0xE0,        // STA $E001   enable
+    0x4C, 0x19, 0xE0,        // spin: JMP spin
+    0xA9, 0x0F,              // dmc: LDA #$0F
+    0x8D, 0x10, 0x40,        // STA $4010   fastest rate, no IRQ
+    0xA9, 0x01,              // LDA #$01
+    0x8D, 0x13, 0x40,        // STA $4013   17 bytes from $C000
+    0xA9, 0x10,              // LDA #$10
+    0x8D, 0x15, 0x40,        // STA $4015   start the sample
+    0x4C, 0x19, 0xE0,        // JMP spin
+};
+
+typedef enum { FLAG_MMC3 = 1, FLAG_DMC = 2 } flag_t;
+
+typedef struct {
+  nes_t *nes;
+  event_handler_t handler;
+  void *ctx;
+  bool fired;
+  uint64_t when;
+  uint64_t now;
+} event_probe_t;
+
+typedef struct {
+  const char *name;
+  flag_t flag;
+  event_type_t type;
+  bool armed;         // the MMC3 IRQ is already pending when the ROM writes to it
+  uint16_t last_dot;  // the flag is set from dot 0 up to this one
+} test_case_t;
+
+// The ROM needs about 60 dots after the flag is set to enable the MMC3 IRQ, before the A12 rise.
+// 8 DMC output cycles at the fastest rate take 432 CPU cycles, or 1296 dots.
+static const test_case_t test_cases[] = {
+    {"MMC3 IRQ enabled", FLAG_MMC3, EVENT_MAPPER_IRQ, false, 160},
+    {"MMC3 IRQ moved earlier", FLAG_MMC3, EVENT_MAPPER_IRQ, true, 160},
+    {"DMC fetch", FLAG_DMC, EVENT_DMC_FETCH, false, 1300},
+};
+
+typedef struct {
+  size_t checks;
+  size_t failures;
+} check_t;
+
+private
+void check(check_t *c, bool ok, const char *what, const test_case_t *test_case, uint16_t dot) {
+  c->checks++;
+  if (!ok) {
+    c->failures++;
+    log_error("%s: %s, flag set at dot %u", test_case->name, what, dot);
+  }
+}
+
+// Stands in for the handler of the event under test to record when it first runs
+private
+void on_probed_event(void *ctx, uint64_t when) {
+  event_probe_t *probe = ctx;
+  if (!probe->fired) {
+    probe->fired = true;
+    probe->when = when;
+    probe->now = nes_now(probe->nes);
+  }
+  probe->handler(probe->ctx, when);
+}
+
+private
+void make_rom(uint8_t *rom) {
+  // mapper 4, vertical mirroring
+  uint8_t header[HEADER_SIZE] = {'N', 'E', 'S', 0x1A, PRG_ROM_SIZE / 16384, CHR_ROM_SIZE / 8192,
+                                 0x41};
+  memset(rom, 0, ROM_SIZE);
+  memcpy(rom, header, sizeof(header));
+
+  uint8_t *last_bank = rom + HEADER_SIZE + PRG_ROM_SIZE - 8 * 1024;
+  memcpy(last_bank, program, sizeof(program));
+
+  // NMI, reset and IRQ all point at $E000
+  uint8_t *vectors = rom + HEADER_SIZE + PRG_ROM_SIZE - 6;
+  for (uint8_t i = 0; i < 6; i += 2) {
+    vectors[i] = 0x00;
+    vectors[i + 1] = 0xE0;
+  }
+}
+
+[[nodiscard]] private
+bool write_rom(char *path, const uint8_t *rom) {
+  int fd = mkstemp(path);
+  bool written = fd >= 0 && write(fd, rom, ROM_SIZE) == (ssize_t)ROM_SIZE;
+  if (fd >= 0) {
+    close(fd);
+  }
+  return written;
+}
+
+// Runs the ROM with the flag set at `dot` of TEST_SCANLINE in its first frame. An armed MMC3 IRQ
+// is enabled ARMED_LATCH + 1 scanlines ahead before that, the one byte DMC sample is started right
+// after reset.
+private
+void check_dot(check_t *c, nes_t *nes, cartridge_t *cart, const test_case_t *test_case,
+               uint16_t dot) {
+  nes_power_on(nes);
+  if (!nes_insert_cartridge(nes, cart)) {
+    check(c, false, "cannot insert the cartridge", test_case, dot);
+    return;
+  }
+  nes_reset(nes);
+  if (test_case->flag == FLAG_DMC) {
+    bus_write(&nes->cpu.bus, 0x4010, 0x0F);
+    bus_write(&nes->cpu.bus, 0x4013, 0x00);
+    bus_write(&nes->cpu.bus, 0x4015, 0x10);
+  }
+
+  event_probe_t probe = {.nes = nes,
+                         .handler = nes->scheduler.handlers[test_case->type],
+                         .ctx = nes->scheduler.ctx[test_case->type]};
+  scheduler_set_handler(&nes->scheduler, test_case->type, on_probed_event, &probe);
+
+  // the scanline event keeps the PPU state at most one scanline behind
+  while (nes->ppu.state.scanline != TEST_SCANLINE) {
+    nes_run_until(nes, nes_now(nes) + 1);
+  }
+  uint64_t scanline_start = nes->ppu.state.scanline_start;
+  uint64_t scanline_end = scanline_start + PPU_DOTS_PER_SCANLINE * nes->master_clocks_per_ppu_dot;
+
+  uint64_t flag_time = scanline_start + dot * nes->master_clocks_per_ppu_dot;
+  nes_run_until(nes, flag_time);
+  if (test_case->armed) {
+    bus_write(&nes->cpu.bus, 0xC000, ARMED_LATCH);
+    bus_write(&nes->cpu.bus, 0xC001, 0);
+    bus_write(&nes->cpu.bus, 0xE001, 0);
+  }
+  bus_write(&nes->cpu.bus, FLAG_ADDR, test_case->flag);
+
+  if (test_case->flag == FLAG_MMC3) {
+    nes_run_until(nes, scanline_end);
+    check(c, probe.fired, "the event did not fire on the scanline it was enabled on", test_case,
+          dot);
+    check(c, probe.when < scanline_end, "the IRQ was not predicted before the end of the scanline",
+          test_case, dot);
+    check(c, (nes->cpu.irq_lines & IRQ_SOURCE_MAPPER) != 0, "the IRQ line is not asserted",
+          test_case, dot);
+  } else {
+    nes_run_until(nes, flag_time + DMC_SCANLINES * (scanline_end - scanline_start));
+    check(c, probe.fired, "the event did not fire", test_case, dot);
+  }
+  check(c, probe.now - probe.when < SPIN_LOOP_CYCLES * nes->master_clocks_per_cpu_cycle,
+        "the event fired late", test_case, dot);
+
+  // `probe` goes out of scope
+  scheduler_set_handler(&nes->scheduler, test_case->type, probe.handler, probe.ctx);
+}
+
+int main(void) {
+  arena_t arena;
+  return_value_if(!arena_new(&arena, ARENA_BLOCK_SIZE), EXIT_FAILURE, "out of memory");
+  load_rom_set_verbose(false);
+
+  uint8_t rom[ROM_SIZE];
+  make_rom(rom);
+  char path[] = "/tmp/irq_timing_check_XXXXXX";
+  bool written = write_rom(path, rom);
+
+  nes_t *nes = new (&arena, nes_t);
+  cartridge_t cart = cart_new();
+  bool ok = written && nes != nullptr && load_rom_file(&arena, &cart, path) && fill_header(&cart);
+  if (written) {
+    unlink(path);
+  }
+  return_value_if(!ok, EXIT_FAILURE, "cannot load the synthetic ROM");
+
+  check_t c = {};
+  for (size_t i = 0; i < sizeof(test_cases) / sizeof(test_cases[0]); i++) {
+    for (uint16_t dot = 0; dot <= test_cases[i].last_dot; dot += DOT_STEP) {
+      check_dot(&c, nes, &cart, &test_cases[i], dot);
+    }
+  }
+
+  printf("%zu/%zu checks passed\n", c.checks - c.failures, c.checks);
+
+  cart_release(&cart);
+  arena_free(&arena);
+  return c.failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,336 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+// Runs ROMs headless, many consoles at once, and reports hashes of what they produced. Every job
+// powers on its own console, runs it for a number of frames, optionally playing an input movie,
+// and prints one CSV row, in the order the jobs were given.
+//
+// The jobs are split into one share per thread up front. A thread works through its own share and
+// then steals single jobs from the others, the only shared state is an atomic counter per share.
+// Every thread has its own arena, a job's console and ROM are released when it finishes.
+//
+// usage: nes_batch [-j threads] [-n frames] [-a] [-v] [-f job file] [rom...]
+//   -j  number of threads, the number of online CPUs by default
+//   -n  frames to run per job, 600 by default
+//   -a  also hash every frame instead of only the last one
+//   -v  verify mode: no pixels or samples are produced until the last frame, ignored with -a
+//   -f  file with one job per line: <rom>[,[frames][,movie]], lines starting with # are skipped.
+//       Jobs with a movie and without a number of frames run to the end of the movie.
+#include <stdlib.h>
+#include <threads.h>
+#include <unistd.h>
+
+#include "../alloc.h"
+#include "../hash.h"
+#include "../load_rom.h"
+#include "../movie.h"
+#include "../nes.h"
+#include "../utils.h"
+#include "tool_utils.h"
+
+static constexpr uint32_t DEFAULT_FRAMES = 600;
+static constexpr size_t ARENA_BLOCK_SIZE = 4 * 1024 * 1024;
+
+typedef struct {
+  char *rom_path;
+  char *movie_path;  // nullptr without a movie
+  uint32_t frames;   // 0 runs the whole movie
+} job_t;
+
+typedef struct {
+  job_t *items;
+  size_t count;
+  size_t capacity;
+} job_list_t;
+
+typedef struct {
+  bool ok;
+  uint32_t frames;
+  uint32_t frame_crc32;   // framebuffer after the last frame
+  uint32_t frames_crc32;  // every framebuffer, with -a
+  uint32_t ram_crc32;
+  uint64_t cpu_cycles;
+  uint64_t nanoseconds;
+} job_result_t;
+
+// The jobs not yet taken by any thread, on its own cache line so that the owner does not contend
+// with the counters of the other shares
+typedef struct {
+  alignas(64) work_queue_t queue;
+} shard_t;
+
+typedef struct {
+  const job_list_t *jobs;
+  job_result_t *results;
+  shard_t *shards;
+  size_t shard_count;
+  bool hash_all_frames;
+  bool verify;
+} batch_t;
+
+typedef struct {
+  batch_t *batch;
+  size_t index;
+  size_t jobs_run;
+  size_t jobs_stolen;
+  size_t arena_high_water;
+} worker_t;
+
+[[nodiscard]] private
+bool push_job(job_list_t *jobs, const char *rom_path, uint32_t frames, const char *movie_path) {
+  if (jobs->count == jobs->capacity) {
+    size_t capacity = jobs->capacity ? 2 * jobs->capacity : 1024;
+    job_t *items = realloc(jobs->items, capacity * sizeof(*items));
+    return_value_if(items == nullptr, false, "out of memory");
+    jobs->items = items;
+    jobs->capacity = capacity;
+  }
+
+  job_t job = {strdup(rom_path), movie_path ? strdup(movie_path) : nullptr, frames};
+  return_value_if(job.rom_path == nullptr || (movie_path && job.movie_path == nullptr), false,
+                  "out of memory");
+  jobs->items[jobs->count++] = job;
+  return true;
+}
+
+[[nodiscard]] private
+bool read_job_file(job_list_t *jobs, const char *file_path, uint32_t default_frames) {
+  FILE *filep = fopen(file_path, "r");
+  return_value_if(filep == nullptr, false, "cannot open file: %s", file_path);
+
+  bool ok = true;
+  char line[4096];
+  while (ok && fgets(line, sizeof(line), filep) != nullptr) {
+    line[strcspn(line, "\r\n")] = '\0';
+    if (line[0] == '\0' || line[0] == '#') {
+      continue;
+    }
+
+    char *frames_field = strchr(line, ',');
+    char *movie_path = nullptr;
+    if (frames_field != nullptr) {
+      *frames_field++ = '\0';
+      movie_path = strchr(frames_field, ',');
+      if (movie_path != nullptr) {
+        *movie_path++ = '\0';
+        movie_path = *movie_path != '\0' ? movie_path : nullptr;
+      }
+    }
+
+    uint32_t frames = movie_path ? 0 : default_frames;
+    if (frames_field != nullptr && *frames_field != '\0') {
+      frames = (uint32_t)strtoul(frames_field, nullptr, 10);
+    }
+    ok = push_job(jobs, line, frames, movie_path);
+  }
+
+  fclose(filep);
+  return ok;
+}
+
+private
+void run_job(const batch_t *batch, const job_t *job, job_result_t *result, arena_t *arena) {
+  arena_scope_t scope = arena_scope_begin(arena);
+  nes_t *nes = new (arena, nes_t);
+  cartridge_t cart = cart_new();
+  movie_t movie = {};
+
+  result->ok = nes != nullptr && load_rom_file(arena, &cart, job->rom_path) &&
+               fill_header(&cart) &&
+               (job->movie_path == nullptr || movie_load(arena, &movie, job->movie_path));
+  if (result->ok) {
+    nes_power_on(nes);
+    result->ok = nes_insert_cartridge(nes, &cart);
+  }
+
+  if (result->ok) {
+    result->frames = job->frames ? job->frames : (uint32_t)movie.frame_count;
+
+    uint64_t start = now_ns();
+    nes_reset(nes);
+    if (batch->hash_all_frames) {
+      for (uint32_t frame = 0; frame < result->frames; frame++) {
+        movie_run_frame(nes, &movie, frame);
+        result->frames_crc32 = crc32_update(result->frames_crc32, &nes->ppu.framebuffer[0][0],
+                                            sizeof(nes->ppu.framebuffer));
+      }
+    } else {
+      movie_run(nes, &movie, result->frames, batch->verify);
+    }
+    result->nanoseconds = now_ns() - start;
+
+    result->frame_crc32 =
+        crc32_update(0, &nes->ppu.framebuffer[0][0], sizeof(nes->ppu.framebuffer));
+    result->ram_crc32 = crc32_update(0, nes->cpu.mem, sizeof(nes->cpu.mem));
+    result->cpu_cycles = nes->cpu.cycles;
+  }
+
+  cart_release(&cart);
+  arena_scope_end(scope);
+}
+
+private
+int batch_worker(void *arg) {
+  worker_t *worker = arg;
+  batch_t *batch = worker->batch;
+
+  arena_t arena;
+  if (!arena_new(&arena, ARENA_BLOCK_SIZE)) {
+    return thrd_error;
+  }
+
+  load_rom_set_verbose(false);
+  // the own share first, then the others in turn, starting with the next one so that the thieves
+  // spread out over the victims
+  for (size_t i = 0; i < batch->shard_count; i++) {
+    shard_t *shard = &batch->shards[(worker->index + i) % batch->shard_count];
+
+    size_t job;
+    while (work_queue_take(&shard->queue, &job)) {
+      run_job(batch, &batch->jobs->items[job], &batch->results[job], &arena);
+      worker->jobs_run++;
+      worker->jobs_stolen += i > 0;
+    }
+  }
+
+  worker->arena_high_water = arena.stats.high_water;
+  arena_free(&arena);
+  return thrd_success;
+}
+
+private
+void print_row(const job_t *job, const job_result_t *result, bool hash_all_frames) {
+  print_csv_string(job->rom_path);
+  putchar(',');
+  if (job->movie_path != nullptr) {
+    print_csv_string(job->movie_path);
+  }
+
+  if (!result->ok) {
+    puts(",,error,,,,,,");
+    return;
+  }
+
+  double seconds = (double)result->nanoseconds / 1e9;
+  printf(",%u,ok,%08x,", result->frames, result->frame_crc32);
+  if (hash_all_frames) {
+    printf("%08x", result->frames_crc32);
+  }
+  printf(",%08x,%llu,%.3f,%.1f\n", result->ram_crc32, (unsigned long long)result->cpu_cycles,
+         seconds * 1e3, seconds > 0 ? result->frames / seconds : 0.0);
+}
+
+int main(int argc, char **argv) {
+  size_t thread_count = parse_thread_count(nullptr);
+  uint32_t frames = DEFAULT_FRAMES;
+  bool hash_all_frames = false;
+  bool verify = false;
+  const char *job_file = nullptr;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "j:n:avf:")) != -1) {
+    switch (opt) {
+      case 'j':
+        thread_count = parse_thread_count(optarg);
+        break;
+      case 'n':
+        frames = (uint32_t)strtoul(optarg, nullptr, 10);
+        break;
+      case 'a':
+        hash_all_frames = true;
+        break;
+      case 'v':
+        verify = true;
+        break;
+      case 'f':
+        job_file = optarg;
+        break;
+      default:
+        return EXIT_FAILURE;
+    }
+  }
+  return_value_if(optind == argc && job_file == nullptr, EXIT_FAILURE,
+                  "usage: %s [-j threads] [-n frames] [-a] [-v] [-f job file] [rom...]", argv[0]);
+
+  job_list_t jobs = {};
+  return_value_if(job_file != nullptr && !read_job_file(&jobs, job_file, frames), EXIT_FAILURE,
+                  "cannot read the jobs");
+  for (int i = optind; i < argc; i++) {
+    return_value_if(!push_job(&jobs, argv[i], frames, nullptr), EXIT_FAILURE,
+                    "cannot read the jobs");
+  }
+
+  size_t worker_count = thread_count < jobs.count ? thread_count : jobs.count;
+  worker_count = worker_count < 1 ? 1 : worker_count;
+
+  job_result_t *results = calloc(jobs.count ? jobs.count : 1, sizeof(*results));
+  shard_t *shards = aligned_alloc(alignof(shard_t), worker_count * sizeof(*shards));
+  worker_t *workers = calloc(worker_count, sizeof(*workers));
+  return_value_if(results == nullptr || shards == nullptr || workers == nullptr, EXIT_FAILURE,
+                  "out of memory");
+
+  // contiguous shares, so that neighbouring jobs (often the same ROM) stay on one thread
+  for (size_t i = 0; i < worker_count; i++) {
+    work_queue_init(&shards[i].queue, jobs.count * i / worker_count,
+                    jobs.count * (i + 1) / worker_count);
+  }
+
+  batch_t batch = {.jobs = &jobs,
+                   .results = results,
+                   .shards = shards,
+                   .shard_count = worker_count,
+                   .hash_all_frames = hash_all_frames,
+                   .verify = verify};
+
+  for (size_t i = 0; i < worker_count; i++) {
+    workers[i] = (worker_t){.batch = &batch, .index = i};
+  }
+
+  // the shares of threads that could not be started are stolen by the others
+  uint64_t start = now_ns();
+  size_t started = run_threads(worker_count, batch_worker, workers, sizeof(*workers));
+  return_value_if(started == 0, EXIT_FAILURE, "cannot start any threads");
+  double seconds = (double)(now_ns() - start) / 1e9;
+
+  size_t stolen = 0;
+  size_t arena_high_water = 0;
+  for (size_t i = 0; i < started; i++) {
+    stolen += workers[i].jobs_stolen;
+    if (workers[i].arena_high_water > arena_high_water) {
+      arena_high_water = workers[i].arena_high_water;
+    }
+  }
+
+  puts("rom,movie,frames,status,frame_crc32,frames_crc32,ram_crc32,cpu_cycles,ms,fps");
+  uint64_t total_frames = 0;
+  for (size_t i = 0; i < jobs.count; i++) {
+    print_row(&jobs.items[i], &results[i], hash_all_frames);
+    total_frames += results[i].ok ? results[i].frames : 0;
+    free(jobs.items[i].rom_path);
+    free(jobs.items[i].movie_path);
+  }
+
+  fprintf(stderr,
+          "%zu jobs, %llu frames in %.3fs on %zu threads (%.0f fps), %zu jobs stolen, "
+          "arena high water %zu bytes per thread\n",
+          jobs.count, (unsigned long long)total_frames, seconds, started,
+          seconds > 0 ? (double)total_frames / seconds : 0.0, stolen, arena_high_water);
+
+  free(jobs.items);
+  free(results);
+  free(shards);
+  free(workers);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+// Plays an input movie against a ROM and prints hashes of the RAM and the last frame, or checks
+// them against expected values.
+//
+// usage: nes_movie [-v] [-n frames] [-r ram crc32] [-p framebuffer crc32] <rom> <movie>
+//   -v  verify mode: no pixels or samples are produced until the last frame, which is rendered so
+//       that its framebuffer can still be hashed
+//   -n  frames to run, the length of the movie by default
+//   -r  expected CRC32 of the 2KiB of internal RAM
+//   -p  expected CRC32 of the framebuffer after the last frame
+//
+// Built with -DNES_STATS the counters of the run are printed to stderr at exit.
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../alloc.h"
+#include "../hash.h"
+#include "../load_rom.h"
+#include "../movie.h"
+#include "../nes.h"
+#include "../utils.h"
+#include "tool_utils.h"
+
+static constexpr size_t ARENA_BLOCK_SIZE = 4 * 1024 * 1024;
+
+[[nodiscard]] private
+bool check_crc32(const char *name, const char *expected, uint32_t actual) {
+  if (expected == nullptr) {
+    return true;
+  }
+  return_value_if(strtoul(expected, nullptr, 16) != actual, false,
+                  "%s CRC32 mismatch: expected %s, got %08x", name, expected, actual);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  bool verify = false;
+  long frames = -1;
+  const char *expected_ram = nullptr;
+  const char *expected_framebuffer = nullptr;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "vn:r:p:")) != -1) {
+    switch (opt) {
+      case 'v':
+        verify = true;
+        break;
+      case 'n':
+        frames = strtol(optarg, nullptr, 10);
+        break;
+      case 'r':
+        expected_ram = optarg;
+        break;
+      case 'p':
+        expected_framebuffer = optarg;
+        break;
+      default:
+        return EXIT_FAILURE;
+    }
+  }
+  return_value_if(optind != argc - 2, EXIT_FAILURE,
+                  "usage: %s [-v] [-n frames] [-r ram crc32] [-p framebuffer crc32] <rom> <movie>",
+                  argv[0]);
+
+  arena_t arena;
+  return_value_if(!arena_new(&arena, ARENA_BLOCK_SIZE), EXIT_FAILURE, "out of memory");
+
+  load_rom_set_verbose(false);
+  nes_t *nes = new (&arena, nes_t);
+  cartridge_t cart = cart_new();
+  movie_t movie;
+  return_value_if(nes == nullptr, EXIT_FAILURE, "out of memory");
+  return_value_if(!load_rom_file(&arena, &cart, argv[optind]) || !fill_header(&cart),
+                  EXIT_FAILURE, "cannot load ROM: %s", argv[optind]);
+  return_value_if(!movie_load(&arena, &movie, argv[optind + 1]), EXIT_FAILURE,
+                  "cannot load movie: %s", argv[optind + 1]);
+
+  nes_power_on(nes);
+  return_value_if(!nes_insert_cartridge(nes, &cart), EXIT_FAILURE, "cannot insert cartridge");
+  nes_reset(nes);
+
+  size_t frame_count = frames >= 0 ? (size_t)frames : movie.frame_count;
+  double start = now_seconds();
+  movie_run(nes, &movie, frame_count, verify);
+  double seconds = now_seconds() - start;
+
+  uint32_t ram_crc32 = crc32_update(0, nes->cpu.mem, sizeof(nes->cpu.mem));
+  uint32_t framebuffer_crc32 =
+      crc32_update(0, &nes->ppu.framebuffer[0][0], sizeof(nes->ppu.framebuffer));
+  printf("frames=%zu ram_crc32=%08x framebuffer_crc32=%08x %.0f fps\n", frame_count, ram_crc32,
+         framebuffer_crc32, seconds > 0 ? (double)frame_count / seconds : 0.0);
+
+#ifdef NES_STATS
+  nes_stats_t stats;
+  nes_get_stats(nes, &stats);
+  nes_print_stats(&stats, stderr);
+#endif
+
+  bool ok = check_crc32("RAM", expected_ram, ram_crc32);
+  ok = check_crc32("framebuffer", expected_framebuffer, framebuffer_crc32) && ok;
+
+  cart_release(&cart);
+  arena_free(&arena);
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,204 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+
+// Checks the ROM database against the test table in rom_db_test.csv. From the src directory:
+//
+//   rom_db_gen tools/rom_db_test.csv > /tmp/rom_db_test_entries.h
+//
+// then build this file with rom_db.c, load_rom.c, alloc.c, hash.c and inflate.c, passing
+// -I. -DROM_DB_ENTRIES='"/tmp/rom_db_test_entries.h"' so that both use the test table.
+//
+// Every entry has to be found by rom_db_find(), the first and the last one included, and the
+// CRCs next to every entry have to miss. A synthetic ROM listed in the table is then written with
+// a wrong iNES header and loaded, fill_header() has to correct it, and has to leave it alone once
+// the database is turned off or the ROM no longer matches.
+//
+// usage: rom_db_check
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../alloc.h"
+#include "../hash.h"
+#include "../load_rom.h"
+#include "../rom_db.h"
+#include "../utils.h"
+
+#ifndef ROM_DB_ENTRIES
+#error "build with -DROM_DB_ENTRIES, see the top of this file"
+#endif
+#include ROM_DB_ENTRIES
+
+static constexpr size_t PRG_ROM_SIZE = 16 * 1024;
+static constexpr size_t CHR_ROM_SIZE = 8 * 1024;
+static constexpr size_t HEADER_SIZE = 16;
+static constexpr size_t ROM_SIZE = HEADER_SIZE + PRG_ROM_SIZE + CHR_ROM_SIZE;
+static constexpr size_t ARENA_BLOCK_SIZE = 64 * 1024;
+
+typedef struct {
+  size_t checks;
+  size_t failures;
+} check_t;
+
+private
+void check(check_t *c, bool ok, const char *what, uint32_t crc32) {
+  c->checks++;
+  if (!ok) {
+    c->failures++;
+    log_error("%s: %08x", what, crc32);
+  }
+}
+
+private
+bool entries_equal(const rom_db_entry_t *a, const rom_db_entry_t *b) {
+  return a->crc32 == b->crc32 && a->mapper_number == b->mapper_number &&
+         a->submapper_number == b->submapper_number &&
+         a->hard_wired_nametable_layout == b->hard_wired_nametable_layout &&
+         a->alternative_nametables == b->alternative_nametables &&
+         a->battery_present == b->battery_present && a->cpu_ppu_timing == b->cpu_ppu_timing;
+}
+
+private
+bool in_table(uint32_t crc32) {
+  for (size_t i = 0; i < ROM_DB_ENTRY_COUNT; i++) {
+    if (rom_db_entries[i].crc32 == crc32) {
+      return true;
+    }
+  }
+  return false;
+}
+
+private
+void check_miss(check_t *c, uint32_t crc32) {
+  if (!in_table(crc32)) {
+    check(c, rom_db_find(crc32) == nullptr, "found a CRC that is not in the table", crc32);
+  }
+}
+
+private
+void check_lookups(check_t *c) {
+  check(c, rom_db_size() == ROM_DB_ENTRY_COUNT, "rom_db.c was built with another table",
+        (uint32_t)rom_db_size());
+
+  for (size_t i = 0; i < ROM_DB_ENTRY_COUNT; i++) {
+    const rom_db_entry_t *entry = &rom_db_entries[i];
+    const rom_db_entry_t *found = rom_db_find(entry->crc32);
+    check(c, found != nullptr && entries_equal(found, entry), "entry not found", entry->crc32);
+    check(c, i == 0 || rom_db_entries[i - 1].crc32 < entry->crc32, "table not sorted",
+          entry->crc32);
+
+    check_miss(c, entry->crc32 - 1);
+    check_miss(c, entry->crc32 + 1);
+  }
+  check_miss(c, 0);
+  check_miss(c, UINT32_MAX);
+}
+
+// An NROM image whose header claims horizontal mirroring, no battery and NTSC, the table lists its
+// CRC with other values
+private
+void make_rom(uint8_t *rom) {
+  uint8_t header[HEADER_SIZE] = {'N', 'E', 'S', 0x1A, PRG_ROM_SIZE / 16384, CHR_ROM_SIZE / 8192};
+  memcpy(rom, header, sizeof(header));
+
+  uint8_t *prg_rom = rom + HEADER_SIZE;
+  uint8_t *chr_rom = prg_rom + PRG_ROM_SIZE;
+  for (size_t i = 0; i < PRG_ROM_SIZE; i++) {
+    prg_rom[i] = (uint8_t)(i * 7 + 3);
+  }
+  for (size_t i = 0; i < CHR_ROM_SIZE; i++) {
+    chr_rom[i] = (uint8_t)(i ^ 0x5A);
+  }
+}
+
+// Writes `rom` to a file, loads it and checks whether its header was corrected to `expected`
+private
+void check_rom(check_t *c, arena_t *arena, const uint8_t *rom, const rom_db_entry_t *expected,
+               uint32_t crc32) {
+  char path[] = "/tmp/rom_db_check_XXXXXX";
+  int fd = mkstemp(path);
+  bool written = fd >= 0 && write(fd, rom, ROM_SIZE) == (ssize_t)ROM_SIZE;
+  if (fd >= 0) {
+    close(fd);
+  }
+  check(c, written, "cannot write the synthetic ROM", crc32);
+
+  arena_scope_t scope = arena_scope_begin(arena);
+  cartridge_t cart = cart_new();
+
+  bool ok = written && load_rom_file(arena, &cart, path) && fill_header(&cart);
+  check(c, ok, "cannot load the synthetic ROM", crc32);
+
+  if (ok && expected != nullptr) {
+    const ines_header_t *header = &cart.ines_header;
+    check(c, cart.header_corrected, "header not corrected", crc32);
+    check(c, header->mapper_number == expected->mapper_number, "mapper not corrected", crc32);
+    check(c, header->hard_wired_nametable_layout == expected->hard_wired_nametable_layout,
+          "mirroring not corrected", crc32);
+    check(c, header->battery_present == expected->battery_present, "battery not corrected",
+          crc32);
+    check(c, (header->tv_system == TV_SYSTEM_PAL) == (expected->cpu_ppu_timing == TIMING_PAL),
+          "TV system not corrected", crc32);
+  } else if (ok) {
+    check(c, !cart.header_corrected && cart.ines_header.mapper_number == 0,
+          "header corrected without a match", crc32);
+  }
+
+  cart_release(&cart);
+  arena_scope_end(scope);
+  if (fd >= 0) {
+    unlink(path);
+  }
+}
+
+private
+void check_override(check_t *c, arena_t *arena) {
+  uint8_t rom[ROM_SIZE];
+  make_rom(rom);
+
+  const uint8_t *prg_and_chr = rom + HEADER_SIZE;
+  uint32_t crc32 = crc32_update(0, prg_and_chr, PRG_ROM_SIZE + CHR_ROM_SIZE);
+  const rom_db_entry_t *entry = rom_db_find(crc32);
+  check(c, entry != nullptr, "the synthetic ROM is not in the table", crc32);
+  if (entry == nullptr) {
+    return;
+  }
+
+  check_rom(c, arena, rom, entry, crc32);
+  load_rom_set_rom_db(false);
+  check_rom(c, arena, rom, nullptr, crc32);
+  load_rom_set_rom_db(true);
+
+  // one flipped CHR bit changes the key
+  rom[ROM_SIZE - 1] ^= 1;
+  crc32 = crc32_update(0, prg_and_chr, PRG_ROM_SIZE + CHR_ROM_SIZE);
+  check_rom(c, arena, rom, in_table(crc32) ? rom_db_find(crc32) : nullptr, crc32);
+}
+
+int main(void) {
+  arena_t arena;
+  return_value_if(!arena_new(&arena, ARENA_BLOCK_SIZE), EXIT_FAILURE, "out of memory");
+  load_rom_set_verbose(false);
+
+  check_t c = {};
+  check_lookups(&c);
+  check_override(&c, &arena);
+
+  printf("%zu/%zu checks passed, %zu entries\n", c.checks - c.failures, c.checks,
+         (size_t)ROM_DB_ENTRY_COUNT);
+
+  arena_free(&arena);
+  return c.failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,173 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+
+// Turns the CSV list of ROMs with bad iNES headers into rom_db_entries.h, sorted by CRC so that
+// rom_db_find() can binary search it. See rom_db.csv for the format.
+//
+// usage: rom_db_gen <rom_db.csv> > rom_db_entries.h
+#include <stdlib.h>
+
+#include "../rom_db.h"
+#include "../utils.h"
+
+static constexpr size_t MAX_LINE_SIZE = 1024;
+
+// the generated file is part of nemesis like any other
+static const char LICENSE[] =
+    "/*\n"
+    "Copyright 2025 समीर सिंह Sameer Singh\n"
+    "\n"
+    "This file is part of nemesis.\n"
+    "\n"
+    "nemesis is free software: you can redistribute it and/or modify it under the terms of the "
+    "GNU\n"
+    "General Public License as published by the Free Software Foundation, either version 3 of "
+    "the\n"
+    "License, or (at your option) any later version.\n"
+    "\n"
+    "nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; "
+    "without even\n"
+    "the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU "
+    "General\n"
+    "Public License for more details.\n"
+    "\n"
+    "You should have received a copy of the GNU General Public License along with nemesis. If "
+    "not, see\n"
+    "<https://www.gnu.org/licenses/>. */\n";
+
+typedef struct {
+  rom_db_entry_t entry;
+  char name[MAX_LINE_SIZE];
+} row_t;
+
+private
+int compare_rows(const void *a, const void *b) {
+  uint32_t crc_a = ((const row_t *)a)->entry.crc32;
+  uint32_t crc_b = ((const row_t *)b)->entry.crc32;
+  return (crc_a > crc_b) - (crc_a < crc_b);
+}
+
+[[nodiscard]] private
+bool parse_mirroring(const char *field, rom_db_entry_t *entry) {
+  // horizontal mirroring comes from nametables arranged vertically and vice versa
+  switch (field[0]) {
+    case 'H':
+      entry->hard_wired_nametable_layout = NAMETABLE_VERTICAL;
+      return true;
+    case 'V':
+      entry->hard_wired_nametable_layout = NAMETABLE_HORIZONTAL;
+      return true;
+    case '4':
+      entry->alternative_nametables = true;
+      return true;
+    default:
+      return false;
+  }
+}
+
+[[nodiscard]] private
+bool parse_timing(const char *field, rom_db_entry_t *entry) {
+  static const char *timings[] = {[TIMING_NTSC] = "NTSC", [TIMING_PAL] = "PAL",
+                                  [TIMING_MULTIPLE] = "MULTIPLE", [TIMING_DENDY] = "DENDY"};
+
+  for (uint8_t i = 0; i < sizeof(timings) / sizeof(*timings); i++) {
+    if (strcmp(field, timings[i]) == 0) {
+      entry->cpu_ppu_timing = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+// crc32,mapper,submapper,mirroring,battery,timing,name - the name may contain commas
+[[nodiscard]] private
+bool parse_row(char *line, row_t *row) {
+  char *fields[7];
+  fields[0] = line;
+  for (uint8_t i = 1; i < 7; i++) {
+    char *comma = strchr(fields[i - 1], ',');
+    if (comma == nullptr) {
+      return false;
+    }
+    *comma = '\0';
+    fields[i] = comma + 1;
+  }
+  fields[6][strcspn(fields[6], "\r\n")] = '\0';
+
+  *row = (row_t){};
+  char *end;
+  row->entry.crc32 = (uint32_t)strtoul(fields[0], &end, 16);
+  bool ok = *end == '\0' && end != fields[0];
+  row->entry.mapper_number = (uint16_t)strtoul(fields[1], &end, 10);
+  ok = ok && *end == '\0';
+  row->entry.submapper_number = (uint8_t)strtoul(fields[2], &end, 10);
+  ok = ok && *end == '\0';
+  row->entry.battery_present = fields[4][0] == '1';
+  snprintf(row->name, sizeof(row->name), "%s", fields[6]);
+
+  return ok && parse_mirroring(fields[3], &row->entry) && parse_timing(fields[5], &row->entry);
+}
+
+int main(int argc, char **argv) {
+  return_value_if(argc != 2, EXIT_FAILURE, "usage: %s <rom_db.csv>", argv[0]);
+
+  FILE *csv_filep __attribute__((cleanup(cleanup_file))) = fopen(argv[1], "r");
+  return_value_if(csv_filep == nullptr, EXIT_FAILURE, "cannot read file: %s", argv[1]);
+
+  row_t *rows = nullptr;
+  size_t count = 0;
+  size_t capacity = 0;
+  char line[MAX_LINE_SIZE];
+  for (size_t line_number = 1; fgets(line, sizeof(line), csv_filep); line_number++) {
+    if (line[0] == '#' || line[0] == '\n' || strncmp(line, "crc32,", 6) == 0) {
+      continue;
+    }
+
+    if (count == capacity) {
+      capacity = capacity ? 2 * capacity : 256;
+      row_t *grown = realloc(rows, capacity * sizeof(*rows));
+      return_value_if(grown == nullptr, EXIT_FAILURE, "out of memory");
+      rows = grown;
+    }
+    return_value_if(!parse_row(line, &rows[count]), EXIT_FAILURE, "%s:%zu: malformed row",
+                    argv[1], line_number);
+    count++;
+  }
+
+  qsort(rows, count, sizeof(*rows), compare_rows);
+  for (size_t i = 1; i < count; i++) {
+    return_value_if(rows[i].entry.crc32 == rows[i - 1].entry.crc32, EXIT_FAILURE,
+                    "%08x is listed twice", rows[i].entry.crc32);
+  }
+
+  fputs(LICENSE, stdout);
+  printf("// Generated by tools/rom_db_gen from rom_db.csv, do not edit\n");
+  printf("#pragma once\n\n#include \"rom_db.h\"\n\n");
+  printf("static constexpr size_t ROM_DB_ENTRY_COUNT = %zu;\n\n", count);
+  printf("// sorted by crc32, the last entry only keeps the array from being empty\n");
+  printf("static const rom_db_entry_t rom_db_entries[ROM_DB_ENTRY_COUNT + 1] = {\n");
+  for (size_t i = 0; i < count; i++) {
+    const rom_db_entry_t *entry = &rows[i].entry;
+    printf("    {0x%08X, %u, %u, %u, %s, %s, %u},  // %s\n", entry->crc32, entry->mapper_number,
+           entry->submapper_number, entry->hard_wired_nametable_layout,
+           entry->alternative_nametables ? "true" : "false",
+           entry->battery_present ? "true" : "false", entry->cpu_ppu_timing, rows[i].name);
+  }
+  printf("    {},\n};\n");
+
+  free(rows);
+  return EXIT_SUCCESS;
+}
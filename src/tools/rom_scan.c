@@ -0,0 +1,203 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+
+// Indexes a ROM library: walks a directory, parses the header of every ROM below it (.nes, or
+// compressed as .gz or .zip) and hashes its PRG and CHR ROM on a pool of threads. Prints one CSV
+// row per file, sorted by path. Uncompressed ROMs are mapped rather than read, so with -H nothing
+// past their header is ever read from disk.
+//
+// usage: rom_scan [-j threads] [-H] <directory>
+//   -j  number of threads, the number of online CPUs by default
+//   -H  only parse the headers, leave the hash columns empty and skip the ROM database
+#include <stdlib.h>
+#include <threads.h>
+#include <unistd.h>
+
+#include "../alloc.h"
+#include "../hash.h"
+#include "../load_rom.h"
+#include "../utils.h"
+#include "tool_utils.h"
+
+static constexpr size_t SCRATCH_BLOCK_SIZE = 1024 * 1024;
+
+static const char *const rom_extensions[] = {".nes", ".gz", ".zip", nullptr};
+
+typedef struct {
+  bool ok;
+  cartridge_t cart;  // only the header fields, the ROM is released once it is hashed
+  uint32_t rom_crc32;  // PRG ROM followed by CHR ROM, the key of the ROM database
+  uint32_t prg_crc32;
+  uint32_t chr_crc32;
+  uint8_t prg_sha1[SHA1_DIGEST_SIZE];
+  uint8_t chr_sha1[SHA1_DIGEST_SIZE];
+} scan_result_t;
+
+typedef struct {
+  const path_list_t *paths;
+  scan_result_t *results;
+  work_queue_t queue;  // indices into paths
+  bool hash;
+} scan_job_t;
+
+private
+void scan_rom(const char *path, scan_result_t *result, arena_t *scratch, bool hash) {
+  cartridge_t *cart = &result->cart;
+  *cart = cart_new();
+
+  arena_scope_t scope = arena_scope_begin(scratch);
+  if (!load_rom_file(scratch, cart, path)) {
+    arena_scope_end(scope);
+    result->ok = false;
+    return;
+  }
+
+  result->ok = fill_header(cart);
+  if (result->ok && hash) {
+    const uint8_t *prg_rom;
+    const uint8_t *chr_rom;
+    size_t prg_rom_size;
+    size_t chr_rom_size;
+    result->ok = cart_get_prg_rom(cart, &prg_rom, &prg_rom_size) &&
+                 cart_get_chr_rom(cart, &chr_rom, &chr_rom_size);
+
+    if (result->ok) {
+      result->prg_crc32 = crc32_update(0, prg_rom, prg_rom_size);
+      result->chr_crc32 = crc32_update(0, chr_rom, chr_rom_size);
+      result->rom_crc32 = crc32_update(result->prg_crc32, chr_rom, chr_rom_size);
+      sha1(prg_rom, prg_rom_size, result->prg_sha1);
+      sha1(chr_rom, chr_rom_size, result->chr_sha1);
+    }
+  }
+
+  cart_release(cart);
+  arena_scope_end(scope);
+}
+
+private
+int scan_worker(void *arg) {
+  scan_job_t *job = arg;
+
+  // ROMs that cannot be mapped are copied here, one at a time, compressed ones are decompressed
+  // here. The arena grows to fit the largest ROM and is reused for every one after it.
+  arena_t arena;
+  if (!arena_new(&arena, SCRATCH_BLOCK_SIZE)) {
+    return thrd_error;
+  }
+
+  load_rom_set_verbose(false);
+  load_rom_set_rom_db(job->hash);
+  size_t i;
+  while (work_queue_take(&job->queue, &i)) {
+    scan_rom(job->paths->items[i], &job->results[i], &arena, job->hash);
+  }
+
+  arena_free(&arena);
+  return thrd_success;
+}
+
+private
+void print_sha1(const uint8_t digest[SHA1_DIGEST_SIZE]) {
+  for (size_t i = 0; i < SHA1_DIGEST_SIZE; i++) {
+    printf("%02x", digest[i]);
+  }
+}
+
+private
+void print_row(const char *path, const scan_result_t *result, bool hash) {
+  const cartridge_t *cart = &result->cart;
+  print_csv_string(path);
+
+  if (!result->ok) {
+    puts(",error,,,,,,,,,,,,,,,,,,,,");
+    return;
+  }
+
+  // iNES headers lack some of the NES 2.0 fields, they are printed as the values they imply
+  if (cart->format_type == FORMAT_TYPE_INES2) {
+    const ines2_header_t *h = &cart->ines2_header;
+    printf(",nes2,%u,%u,%zu,%zu,%u,%u,%u,%u,%d,%d,%d,%d,%d,%d", h->mapper_number,
+           h->submapper_number, h->prg_rom_size, h->chr_rom_size, h->prg_ram_size,
+           h->prg_nvram_size, h->chr_ram_size, h->chr_nvram_size, h->hard_wired_nametable_layout,
+           h->alternative_nametables, h->battery_present, h->trainer_area_exists, h->console_type,
+           h->cpu_ppu_timing);
+  } else {
+    const ines_header_t *h = &cart->ines_header;
+    printf(",ines,%u,0,%zu,%zu,%u,0,%d,0,%d,%d,%d,%d,%d,%d", h->mapper_number, h->prg_rom_size,
+           h->chr_rom_size, h->prg_ram_size, h->chr_ram_exists ? 8 * 1024 : 0,
+           h->hard_wired_nametable_layout, h->alternative_nametables, h->battery_present,
+           h->trainer_area_exists, h->console_type,
+           h->tv_system == TV_SYSTEM_PAL ? TIMING_PAL : TIMING_NTSC);
+  }
+
+  printf(",%d", cart->header_corrected);
+  if (hash) {
+    printf(",%08x,%08x,%08x,", result->rom_crc32, result->prg_crc32, result->chr_crc32);
+    print_sha1(result->prg_sha1);
+    putchar(',');
+    print_sha1(result->chr_sha1);
+    putchar('\n');
+  } else {
+    puts(",,,,,");
+  }
+}
+
+int main(int argc, char **argv) {
+  size_t thread_count = parse_thread_count(nullptr);
+  bool hash = true;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "j:H")) != -1) {
+    switch (opt) {
+      case 'j':
+        thread_count = parse_thread_count(optarg);
+        break;
+      case 'H':
+        hash = false;
+        break;
+      default:
+        return EXIT_FAILURE;
+    }
+  }
+  return_value_if(optind != argc - 1, EXIT_FAILURE, "usage: %s [-j threads] [-H] <directory>",
+                  argv[0]);
+
+  path_list_t paths = {};
+  return_value_if(!collect_paths(&paths, argv[optind], rom_extensions), EXIT_FAILURE,
+                  "cannot list ROMs");
+  sort_paths(&paths);
+
+  scan_result_t *results = calloc(paths.count ? paths.count : 1, sizeof(*results));
+  return_value_if(results == nullptr, EXIT_FAILURE, "out of memory");
+
+  scan_job_t job = {.paths = &paths, .results = results, .hash = hash};
+  work_queue_init(&job.queue, 0, paths.count);
+
+  // a thread that could not get its scratch memory leaves its share to the others
+  return_value_if(run_threads(thread_count, scan_worker, &job, 0) == 0, EXIT_FAILURE,
+                  "cannot start any threads");
+
+  puts("path,format,mapper,submapper,prg_rom_size,chr_rom_size,prg_ram_size,prg_nvram_size,"
+       "chr_ram_size,chr_nvram_size,nametable_layout,alternative_nametables,battery,trainer,"
+       "console_type,timing,header_corrected,rom_crc32,prg_crc32,chr_crc32,prg_sha1,chr_sha1");
+  for (size_t i = 0; i < paths.count; i++) {
+    print_row(paths.items[i], &results[i], hash);
+  }
+
+  free_paths(&paths);
+  free(results);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,223 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#define _GNU_SOURCE  // sched_setaffinity() and sched_getcpu()
+
+#include "tool_utils.h"
+
+#include <dirent.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../utils.h"
+
+bool push_path(path_list_t *paths, const char *path) {
+  if (paths->count == paths->capacity) {
+    size_t capacity = paths->capacity ? 2 * paths->capacity : 1024;
+    char **items = realloc(paths->items, capacity * sizeof(*items));
+    return_value_if(items == nullptr, false, "out of memory");
+    paths->items = items;
+    paths->capacity = capacity;
+  }
+
+  char *copy = strdup(path);
+  return_value_if(copy == nullptr, false, "out of memory");
+  paths->items[paths->count++] = copy;
+  return true;
+}
+
+private
+bool has_extension(const char *name, const char *const *extensions) {
+  const char *extension = strrchr(name, '.');
+
+  for (; extension != nullptr && *extensions != nullptr; extensions++) {
+    if (strcasecmp(extension, *extensions) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Collects the files below `dir_path`, unreadable directories are skipped with a warning
+[[nodiscard]] private
+bool collect_directory(path_list_t *paths, const char *dir_path, const char *const *extensions) {
+  DIR *dir = opendir(dir_path);
+  if (dir == nullptr) {
+    log_warn("cannot open directory: %s", dir_path);
+    return true;
+  }
+
+  bool ok = true;
+  struct dirent *entry;
+  while (ok && (entry = readdir(dir)) != nullptr) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+      continue;
+    }
+
+    char path[4096];
+    if ((size_t)snprintf(path, sizeof(path), "%s/%s", dir_path, entry->d_name) >= sizeof(path)) {
+      log_warn("path too long, skipped: %s/%s", dir_path, entry->d_name);
+      continue;
+    }
+
+    // not every file system fills in d_type
+    bool is_dir = entry->d_type == DT_DIR;
+    bool is_file = entry->d_type == DT_REG;
+    struct stat st;
+    if (entry->d_type == DT_UNKNOWN && stat(path, &st) == 0) {
+      is_dir = S_ISDIR(st.st_mode);
+      is_file = S_ISREG(st.st_mode);
+    }
+
+    if (is_dir) {
+      ok = collect_directory(paths, path, extensions);
+    } else if (is_file && has_extension(entry->d_name, extensions)) {
+      ok = push_path(paths, path);
+    }
+  }
+
+  closedir(dir);
+  return ok;
+}
+
+// Adds `path` if it is not a directory, so that a missing file is reported by whoever opens it.
+// Otherwise adds every file below it whose extension, ignoring case, is one of the nullptr
+// terminated `extensions`.
+bool collect_paths(path_list_t *paths, const char *path, const char *const *extensions) {
+  struct stat st;
+  if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode)) {
+    return push_path(paths, path);
+  }
+  return collect_directory(paths, path, extensions);
+}
+
+private
+int compare_paths(const void *a, const void *b) {
+  return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+void sort_paths(path_list_t *paths) {
+  if (paths->count > 0) {
+    qsort(paths->items, paths->count, sizeof(*paths->items), compare_paths);
+  }
+}
+
+void free_paths(path_list_t *paths) {
+  for (size_t i = 0; i < paths->count; i++) {
+    free(paths->items[i]);
+  }
+  free(paths->items);
+  *paths = (path_list_t){};
+}
+
+void work_queue_init(work_queue_t *queue, size_t begin, size_t end) {
+  atomic_init(&queue->next, begin);
+  queue->end = end;
+}
+
+// Takes the next index, false once they are all taken. The threads only contend on one counter.
+bool work_queue_take(work_queue_t *queue, size_t *index) {
+  *index = atomic_fetch_add_explicit(&queue->next, 1, memory_order_relaxed);
+  return *index < queue->end;
+}
+
+// The number of threads asked for with -j, `arg` is nullptr without the option and gives the
+// number of online CPUs. Never less than 1.
+size_t parse_thread_count(const char *arg) {
+  long count = arg != nullptr ? strtol(arg, nullptr, 10) : sysconf(_SC_NPROCESSORS_ONLN);
+  return count < 1 ? 1 : (size_t)count;
+}
+
+// Runs `worker` on `thread_count` threads and waits for them to finish. Thread i gets
+// `args + i * arg_size`, so an `arg_size` of 0 passes them all the same argument. Returns the
+// number of threads that could be started, the workers have to cope with fewer than asked for.
+size_t run_threads(size_t thread_count, thrd_start_t worker, void *args, size_t arg_size) {
+  thrd_t *threads = calloc(thread_count, sizeof(*threads));
+  return_value_if(threads == nullptr, 0, "out of memory");
+
+  size_t started = 0;
+  for (; started < thread_count; started++) {
+    void *arg = (char *)args + started * arg_size;
+    if (thrd_create(&threads[started], worker, arg) != thrd_success) {
+      break;
+    }
+  }
+
+  for (size_t i = 0; i < started; i++) {
+    thrd_join(threads[i], nullptr);
+  }
+
+  free(threads);
+  return started;
+}
+
+void print_csv_string(const char *str) {
+  if (strpbrk(str, ",\"\n") == nullptr) {
+    fputs(str, stdout);
+    return;
+  }
+
+  putchar('"');
+  for (; *str; str++) {
+    if (*str == '"') {
+      putchar('"');
+    }
+    putchar(*str);
+  }
+  putchar('"');
+}
+
+void print_json_string(const char *str) {
+  putchar('"');
+  for (; *str; str++) {
+    if (*str == '"' || *str == '\\') {
+      putchar('\\');
+    }
+    putchar((unsigned char)*str < 0x20 ? '?' : *str);
+  }
+  putchar('"');
+}
+
+uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+double now_seconds(void) { return (double)now_ns() / 1e9; }
+
+// Pins the process to CPU `cpu_index`, -1 for the one it is running on, as benchmarks are only
+// comparable if the scheduler does not move them around. Returns the CPU, or -1 with a warning if
+// the process could not be pinned.
+int pin_to_cpu(int cpu_index) {
+  if (cpu_index == -1) {
+    cpu_index = sched_getcpu();
+  }
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (cpu_index >= 0 && cpu_index < CPU_SETSIZE) {
+    CPU_SET(cpu_index, &set);
+  }
+  if (CPU_COUNT(&set) == 0 || sched_setaffinity(0, sizeof(set), &set) != 0) {
+    log_warn("cannot pin to CPU %d, the results may be noisy", cpu_index);
+    return -1;
+  }
+  return cpu_index;
+}
@@ -0,0 +1,53 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+
+// Helpers shared by the command line tools: file lists, a thread pool handing out indices, output
+// formatting and timing. A tool that includes this header is linked with tool_utils.c.
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <threads.h>
+
+typedef struct {
+  char **items;
+  size_t count;
+  size_t capacity;
+} path_list_t;
+
+// The indices [next, end) not yet taken by any thread
+typedef struct {
+  atomic_size_t next;
+  size_t end;
+} work_queue_t;
+
+[[nodiscard]] bool push_path(path_list_t *paths, const char *path);
+[[nodiscard]] bool collect_paths(path_list_t *paths, const char *path,
+                                 const char *const *extensions);
+void sort_paths(path_list_t *paths);
+void free_paths(path_list_t *paths);
+
+void work_queue_init(work_queue_t *queue, size_t begin, size_t end);
+[[nodiscard]] bool work_queue_take(work_queue_t *queue, size_t *index);
+size_t parse_thread_count(const char *arg);
+size_t run_threads(size_t thread_count, thrd_start_t worker, void *args, size_t arg_size);
+
+void print_csv_string(const char *str);
+void print_json_string(const char *str);
+uint64_t now_ns(void);
+double now_seconds(void);
+int pin_to_cpu(int cpu_index);
@@ -0,0 +1,38 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+
+// Turns a binary bus trace dump (see bus_trace.h) back into the MEM[addr]=val CYC:n text format
+// printed by TRACE_LEVEL_CYCLE builds.
+//
+// usage: trace_decode [-k] <dump>
+//   -k  append whether each access was a read or a write
+#include <stdlib.h>
+
+#include "../bus_trace.h"
+#include "../utils.h"
+
+int main(int argc, char **argv) {
+  bool show_access_kind = argc > 1 && strcmp(argv[1], "-k") == 0;
+  int file_arg = show_access_kind ? 2 : 1;
+  return_value_if(argc <= file_arg, EXIT_FAILURE, "usage: %s [-k] <dump>", argv[0]);
+
+  const char *file_path = argv[file_arg];
+
+  FILE *dump_filep __attribute__((cleanup(cleanup_file))) = fopen(file_path, "rb");
+  return_value_if(dump_filep == nullptr, EXIT_FAILURE, "cannot read file: %s", file_path);
+
+  return bus_trace_decode(dump_filep, stdout, show_access_kind) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,59 @@
+/*
+Copyright 2025 समीर सिंह Sameer Singh
+
+This file is part of nemesis.
+
+nemesis is free software: you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+
+nemesis is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with nemesis. If not, see
+<https://www.gnu.org/licenses/>. */
+#pragma once
+
+#include "utils.h"
+
+// Compile time trace levels, select one with -DTRACE_LEVEL=<n>.
+//
+// TRACE_LEVEL_OFF:         nothing is traced, the arguments of the trace macros are still type
+//                          checked but never evaluated, so this costs nothing at runtime
+// TRACE_LEVEL_INSTRUCTION: one line per executed instruction
+// TRACE_LEVEL_CYCLE:       one line per instruction and one line per bus cycle, this is the format
+//                          used to compare against https://github.com/SingleStepTests/65x02
+#define TRACE_LEVEL_OFF 0
+#define TRACE_LEVEL_INSTRUCTION 1
+#define TRACE_LEVEL_CYCLE 2
+
+#ifndef TRACE_LEVEL
+#ifdef CPU_TESTS
+#define TRACE_LEVEL TRACE_LEVEL_CYCLE
+#else
+#define TRACE_LEVEL TRACE_LEVEL_OFF
+#endif
+#endif
+
+#if TRACE_LEVEL >= TRACE_LEVEL_INSTRUCTION
+#define trace_instruction(...) log_info(__VA_ARGS__)
+#else
+#define trace_instruction(...) \
+  do {                         \
+    if (0) {                   \
+      log_info(__VA_ARGS__);   \
+    }                          \
+  } while (0)
+#endif
+
+#if TRACE_LEVEL >= TRACE_LEVEL_CYCLE
+#define trace_cycle(...) log_info(__VA_ARGS__)
+#else
+#define trace_cycle(...)     \
+  do {                       \
+    if (0) {                 \
+      log_info(__VA_ARGS__); \
+    }                        \
+  } while (0)
+#endif
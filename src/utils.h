@@ -96,3 +96,12 @@ static inline const char* get_filename_from_path(const char* path) {
 
   return filename;
 }
+
+// Closes the file when the variable goes out of scope:
+//   FILE *filep __attribute__((cleanup(cleanup_file))) = fopen(path, "rb");
+static inline void cleanup_file(FILE** fp) {
+  if (*fp) {
+    fclose(*fp);
+    *fp = nullptr;
+  }
+}